@@ -20,118 +20,568 @@
 */
 #include "AudioBuffer.h"
 
+#include "AudioWorkerPool.h"
+#include "SoundBank.h"
+#include "PcmCache.h"
+#include "AudioExtensions.h"
+#include "AudioMath.h"
+#include "PolyphaseResampler.h"
+
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <new>
+#include <chrono>
+#include <cstring>
 
 #include <ogg.h>
 #include <vorbisfile.h>
 #include <vorbisenc.h>
 
+//An .ogg file sitting in memory, read through the vorbisfile callbacks.
+struct _MemoryReader {
+	const char* data;
+	size_t size;
+	size_t pos;
+};
+
+static size_t memoryRead(void* ptr, size_t size, size_t count, void* source)
+{
+	_MemoryReader* reader = (_MemoryReader*)source;
+	size_t bytes = std::min(size * count, reader->size - reader->pos);
+	memcpy(ptr, reader->data + reader->pos, bytes);
+	reader->pos += bytes;
+	return size ? bytes / size : 0;
+}
+
+static int memorySeek(void* source, ogg_int64_t offset, int whence)
+{
+	_MemoryReader* reader = (_MemoryReader*)source;
+	ogg_int64_t pos = 0;
+	switch (whence) {
+		case SEEK_SET: pos = offset; break;
+		case SEEK_CUR: pos = (ogg_int64_t)reader->pos + offset; break;
+		case SEEK_END: pos = (ogg_int64_t)reader->size + offset; break;
+		default: return -1;
+	}
+	if (pos < 0 || pos > (ogg_int64_t)reader->size) return -1;
+	reader->pos = (size_t)pos;
+	return 0;
+}
+
+static long memoryTell(void* source)
+{
+	return (long)((_MemoryReader*)source)->pos;
+}
+
 //credit to https://gist.github.com/tilkinsc/f91d2a74cff62cc3760a7c9291290b29 for this loader
-ALuint loadOgg(const char* path)
+bool AudioBuffer::m_decodeVorbis(OggVorbis_File& vf, const _DecodeOptions& options, const _PcmAllocator& alloc, _DecodedAudio& out)
 {
-	ALenum error = 0;
-	ALuint sound = 0;
-	FILE* fp = 0;
-	OggVorbis_File vf;
 	vorbis_info* vi = 0;
-	ALenum format = 0;
-	short* pcmout = 0;
 
-	size_t dataLength;
+	vi = ov_info(&vf, -1);
+	bool useFloat = options.precision == PRECISION_FLOAT32;
+	bool downmix = options.downmix && vi->channels > 1;
+	int channels = downmix ? 1 : vi->channels;
+	if (useFloat) out.format = channels == 1 ? AL_FORMAT_MONO_FLOAT32 : AL_FORMAT_STEREO_FLOAT32;
+	else out.format = channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+	PolyphaseResampler resampler;
+	bool resample = options.resampleRate > 0 && resampler.init(channels, (int)vi->rate, options.resampleRate);
+	out.rate = resample ? (ALsizei)options.resampleRate : (ALsizei)vi->rate;
+	out.channels = channels;
 
-	fp = fopen(path, "rb");
-	if (!fp) {
-		std::cerr << "Could not open file: " << path << std::endl;
-		return 0;
+	ogg_int64_t totalFrames = ov_pcm_total(&vf, -1);
+	if (totalFrames <= 0) {
+		std::cerr << "This ogg file is empty or can't be measured.\n";
+		return false;
 	}
-	alGenBuffers(1, &sound);
-	error = alGetError();
-	if (error != AL_NO_ERROR) {
-		std::cerr << "Error creating buffer: " << path << ", buffer=" << sound << ", error=" << error << std::endl;
-		fclose(fp);
-		return 0;
+	size_t outFrames = resample ? resampler.outputFrames((size_t)totalFrames) : (size_t)totalFrames;
+	size_t frameBytes = (size_t)channels * m_bytesPerSample(out.format);
+	size_t dataLength = outFrames * frameBytes;
+	out.savedBytes = outFrames * (vi->channels - channels) * m_bytesPerSample(out.format);
+	out.resampleBytes = ((int64_t)outFrames - (int64_t)totalFrames) * (int64_t)frameBytes;
+	char* dest = alloc ? alloc(out, dataLength) : nullptr;
+	if (!dest) {
+		out.pcm.reset(new (std::nothrow) char[dataLength]);
+		if (!out.pcm) {
+			std::cerr << "Out of memory. What the hell are you doing?\n";
+			return false;
+		}
+		dest = out.pcm.get();
+	}
+	//the decoder hands back planar floats, which get mixed down and resampled if asked, then interleaved (and converted, for 16-bit)
+	//straight into the final buffer
+	const size_t CHUNK_FRAMES = 4096;
+	std::vector<float> mono(downmix && (!useFloat || resample) ? CHUNK_FRAMES : 0); //downmixes that can't go straight into dest
+	const float* monoPlane = mono.data();
+	size_t frames = 0;
+	auto emit = [&](const float* const* planes, size_t count) {
+		count = std::min(count, outFrames - frames); //the resampler's filter can run a frame or two past the end
+		if (useFloat) interleaveFloat(planes, channels, count, (float*)dest + frames * channels);
+		else interleaveInt16(planes, channels, count, (int16_t*)dest + frames * channels);
+		frames += count;
+	};
+	auto resampleChunk = [&](const float* const* planes, size_t count) {
+		auto start = std::chrono::steady_clock::now();
+		size_t made = planes ? resampler.process(planes, count) : resampler.flush();
+		out.resampleMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		emit(resampler.output(), made);
+	};
+	size_t read = 0;
+	int sel = 0;
+	while (read < (size_t)totalFrames) {
+		float** planes = nullptr;
+		long got = ov_read_float(&vf, &planes, (int)std::min<size_t>(CHUNK_FRAMES, (size_t)totalFrames - read), &sel);
+		if (got == 0) break;
+		if (got < 0) {
+			std::cerr << "This ogg file is faulty.\n";
+			if (got == OV_HOLE) continue;
+			break;
+		}
+		read += (size_t)got;
+		if (downmix && useFloat && !resample) {
+			downmixToMono(planes, vi->channels, (size_t)got, (float*)dest + frames);
+			frames += (size_t)got;
+			continue;
+		}
+		const float* const* src = planes;
+		if (downmix) {
+			downmixToMono(planes, vi->channels, (size_t)got, mono.data());
+			src = &monoPlane;
+		}
+		if (resample) resampleChunk(src, (size_t)got);
+		else emit(src, (size_t)got);
+	}
+	if (resample) resampleChunk(nullptr, 0);
+	if (frames * frameBytes < dataLength) memset(dest + frames * frameBytes, 0, dataLength - frames * frameBytes); //a mapped buffer plays all of it
+	out.data = dest;
+	out.size = frames * frameBytes;
+	return true;
+}
+
+uint64_t AudioBuffer::m_cacheVariant(const _DecodeOptions& options)
+{
+	//the default options come out as 0, so entries cached before there were any options still get used
+	return (uint64_t)(options.precision == PRECISION_FLOAT32) | ((uint64_t)options.downmix << 1) | ((uint64_t)options.resampleRate << 8);
+}
+
+bool AudioBuffer::m_matchesOptions(ALenum format, int channels, const _DecodeOptions& options)
+{
+	bool isFloat = format == AL_FORMAT_MONO_FLOAT32 || format == AL_FORMAT_STEREO_FLOAT32;
+	if (isFloat != (options.precision == PRECISION_FLOAT32)) return false;
+	return !(options.downmix && channels > 1);
+}
+
+int AudioBuffer::m_bytesPerSample(ALenum format)
+{
+	switch (format) {
+		case AL_FORMAT_MONO8:
+		case AL_FORMAT_STEREO8:
+			return 1;
+		case AL_FORMAT_MONO_FLOAT32:
+		case AL_FORMAT_STEREO_FLOAT32:
+			return 4;
+		default:
+			return 2;
 	}
+}
 
+bool AudioBuffer::m_decode(const std::string& fname, const _DecodeOptions& options, const _PcmAllocator& alloc, _DecodedAudio& out)
+{
+	OggVorbis_File vf;
+	out.fname = fname;
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if (!fp) {
+		std::cerr << "Could not open file: " << fname << std::endl;
+		return false;
+	}
 	if (ov_open_callbacks(fp, &vf, NULL, 0, OV_CALLBACKS_NOCLOSE) < 0) {
 		std::cerr << "Stream is not a valid OggVorbis stream.\n";
-		goto fail;
+		std::cerr << "Could not load .ogg file.\n";
+		fclose(fp);
+		return false;
+	}
+	bool decoded = m_decodeVorbis(vf, options, alloc, out);
+	if (!decoded) std::cerr << "Could not load .ogg file.\n";
+	fclose(fp);
+	ov_clear(&vf);
+	return decoded;
+}
+
+bool AudioBuffer::m_decodeMemory(const std::string& fname, const char* data, size_t size, const _DecodeOptions& options, const _PcmAllocator& alloc,
+	_DecodedAudio& out)
+{
+	OggVorbis_File vf;
+	out.fname = fname;
+	_MemoryReader reader = { data, size, 0 };
+	ov_callbacks callbacks = { memoryRead, memorySeek, NULL, memoryTell };
+	if (ov_open_callbacks(&reader, &vf, NULL, 0, callbacks) < 0) {
+		std::cerr << "Stream is not a valid OggVorbis stream: " << fname << std::endl;
+		return false;
 	}
+	bool decoded = m_decodeVorbis(vf, options, alloc, out);
+	if (!decoded) std::cerr << "Could not load .ogg file.\n";
+	ov_clear(&vf);
+	return decoded;
+}
 
-	vi = ov_info(&vf, -1);
-	format = vi->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-
-	dataLength = ov_pcm_total(&vf, -1) * vi->channels * 2;
-	pcmout = (short*)malloc(dataLength);
-	if (pcmout == 0) {
-		std::cerr << "Out of memory. What the hell are you doing?\n";
-		goto fail;
-	}
-	for (size_t size = 0, offset = 0, sel = 0;
-		(size = ov_read(&vf, (char*)pcmout + offset, 4096, 0, 2, 1, (int*)&sel)) != 0;
-		offset += size) {
-		if (size < 0) {
-			std::cerr << "This ogg file is faulty.\n";
+bool AudioBuffer::m_loadSource(const std::string& fname, const char* bankData, size_t bankSize, PcmCache* cache, const _DecodeOptions& options,
+	const _PcmAllocator& alloc, _DecodedAudio& out)
+{
+	if (bankData) return m_decodeMemory(fname, bankData, bankSize, options, alloc, out);
+
+	//the same file decoded with other options (by the other buffer, or before the options changed) gets its own entry
+	PcmCache::CachedPcm cached;
+	uint64_t variant = m_cacheVariant(options);
+	if (cache && cache->lookup(fname, cached, variant) && m_matchesOptions(cached.format, cached.channels, options)) {
+		out.fname = fname;
+		out.format = cached.format;
+		out.rate = cached.rate;
+		out.channels = cached.channels;
+		out.data = cached.data;
+		out.size = cached.size;
+		out.mapped = std::move(cached.file);
+		return true;
+	}
+	if (!m_decode(fname, options, alloc, out)) return false;
+	if (cache) cache->store(fname, out.format, out.rate, out.channels, out.data, out.size, variant);
+	return true;
+}
+
+bool AudioBuffer::mountBank(const std::string& path, const std::string& prefix)
+{
+	auto bank = std::make_shared<SoundBank>();
+	if (!bank->open(path)) return false;
+	std::cout << "Mounted sound bank " << path << " (" << bank->getCount() << " sounds)" << std::endl;
+	m_banks.push_back({ bank, prefix });
+	return true;
+}
+
+bool AudioBuffer::m_findInBanks(const std::string& fname, std::shared_ptr<SoundBank>& bank, const char*& data, size_t& size) const
+{
+	for (const auto& mounted : m_banks) {
+		if (fname.compare(0, mounted.prefix.size(), mounted.prefix) != 0) continue;
+		if (mounted.bank->find(fname.substr(mounted.prefix.size()), data, size)) {
+			bank = mounted.bank;
+			return true;
+		}
+	}
+	return false;
+}
+
+AudioBuffer::_PcmAllocator AudioBuffer::m_mappedAllocator()
+{
+	//a static buffer needs no copy at all from any thread, so mapping is only worth it without one
+	if (!m_ext || m_ext->hasStaticBuffers() || !m_ext->hasMapBuffer()) return nullptr;
+	const AudioExtensions* ext = m_ext;
+	return [ext](_DecodedAudio& audio, size_t bytes) -> char* {
+		ALuint buf = 0;
+		alGetError();
+		alGenBuffers(1, &buf);
+		if (alGetError() != AL_NO_ERROR) return nullptr;
+		void* data = ext->mapNewBuffer(buf, audio.format, (ALsizei)bytes, audio.rate);
+		if (!data) {
+			alDeleteBuffers(1, &buf);
+			return nullptr;
+		}
+		audio.mappedBuffer = buf;
+		audio.mappedSize = bytes;
+		return (char*)data;
+	};
+}
+
+void AudioBuffer::m_discardMapped(_DecodedAudio& audio)
+{
+	if (audio.mappedBuffer == 0) return;
+	m_ext->unmapBuffer(audio.mappedBuffer);
+	alDeleteBuffers(1, &audio.mappedBuffer);
+	audio.mappedBuffer = 0;
+}
+
+ALuint AudioBuffer::m_upload(_DecodedAudio& audio)
+{
+	ALenum error = 0;
+	ALuint sound = audio.mappedBuffer;
+	std::unique_ptr<char[]> staticPcm;
+
+	if (sound != 0) { //already sitting in OpenAL's memory, it just needs letting go of
+		alGetError();
+		m_ext->unmapBuffer(sound);
+		error = alGetError();
+		if (error != AL_NO_ERROR) {
+			std::cerr << "Failed to unmap buffer: " << audio.fname << ", error=" << error << std::endl;
+			alDeleteBuffers(1, &sound);
+			return 0;
 		}
+		audio.size = audio.mappedSize;
 	}
-	alBufferData(sound, format, pcmout, (ALsizei)dataLength, (ALsizei)vi->rate);
-	error = alGetError();
-	if (error != AL_NO_ERROR) {
-		std::cerr << "Failed to send audio info to OpenAL.\n";
-		goto fail;
+	else {
+		alGetError();
+		alGenBuffers(1, &sound);
+		error = alGetError();
+		if (error != AL_NO_ERROR) {
+			std::cerr << "Error creating buffer: " << audio.fname << ", buffer=" << sound << ", error=" << error << std::endl;
+			return 0;
+		}
+		//PCM that was decoded onto the heap can be handed over as is. PCM from the cache is a mapped file that could go away, so it gets copied.
+		if (audio.pcm && m_ext && m_ext->hasStaticBuffers() &&
+			m_ext->bufferDataStatic(sound, audio.format, audio.pcm.get(), (ALsizei)audio.size, audio.rate)) {
+			staticPcm = std::move(audio.pcm);
+		}
+		else {
+			alBufferData(sound, audio.format, audio.data, (ALsizei)audio.size, audio.rate);
+			error = alGetError();
+			if (error != AL_NO_ERROR) {
+				std::cerr << "Failed to send audio info to OpenAL.\n";
+				alDeleteBuffers(1, &sound);
+				return 0;
+			}
+		}
 	}
+	audio.mappedBuffer = 0;
+	audio.pcm.reset();
+	audio.mapped.reset();
+	audio.data = nullptr;
 
-	fclose(fp);
-	ov_clear(&vf);
-	free(pcmout);
+	std::cout << "Loaded " << audio.fname << std::endl;
+	buffers[audio.fname] = sound;
+	_BufferEntry& entry = m_entries[sound];
+	float frameSize = (float)(audio.channels * m_bytesPerSample(audio.format));
+	entry.fname = audio.fname;
+	entry.bytes = audio.size;
+	entry.length = audio.rate > 0 ? (float)audio.size / (frameSize * (float)audio.rate) : 0.f;
+	entry.lastUse = ++m_useCounter;
+	if (staticPcm) {
+		entry.staticPcm = std::move(staticPcm);
+		m_staticBytes += audio.size;
+	}
+	m_residentBytes += audio.size;
+	m_downmixSavedBytes += audio.savedBytes;
+	if (audio.resampleMs > 0.f) {
+		++m_resampled;
+		m_resampleBytes += audio.resampleBytes;
+	}
+	++m_misses;
 	return sound;
-
-fail:
-	std::cerr << "Could not load .ogg file.\n";
-	fclose(fp);
-	ov_clear(&vf);
-	free(pcmout);
-	return 0;
 }
 
 ALuint AudioBuffer::loadAudio(std::string fname)
 {
 	if (buffers.find(fname) != buffers.end()) return buffers[fname];
 
-	ALuint sound = loadOgg(fname.c_str());
+	_DecodedAudio audio;
+	ALuint sound = 0;
+	std::shared_ptr<SoundBank> bank;
+	const char* data = nullptr;
+	size_t size = 0;
+	m_findInBanks(fname, bank, data, size);
+	bool decoded = m_loadSource(fname, data, size, m_cache, m_options, m_mappedAllocator(), audio);
+	if (decoded) sound = m_upload(audio);
+	else m_discardMapped(audio);
 	if (sound == 0) {
 		std::cerr << "Error loading on " << fname << "!\n";
 		return sound;
 	}
-	std::cout << "Loaded " << fname << std::endl;
-	buffers[fname] = sound;
+	m_enforceBudget({ sound });
 	return sound;
 }
-bool AudioBuffer::removeAudio(const ALuint& buf)
+
+std::shared_future<ALuint> AudioBuffer::loadAudioAsync(std::string fname)
 {
-	std::string key = "";
-	for (const auto& [str, val] : buffers) {
-		if (val == buf) {
-			alGetError();
-			alDeleteBuffers(1, &val);
-			auto err = alGetError();
-			if (err != AL_NO_ERROR) {
-				std::cerr << "Something went wrong on removing a buffer - error=" << err << std::endl;
-			}
+	auto pending = m_pending.find(fname);
+	if (pending != m_pending.end()) return pending->second.future;
+
+	if (buffers.find(fname) != buffers.end() || !m_workers) {
+		std::promise<ALuint> ready;
+		ready.set_value(loadAudio(fname));
+		return ready.get_future().share();
+	}
+
+	_PendingLoad& load = m_pending[fname];
+	load.future = load.promise.get_future().share();
+
+	std::shared_ptr<_LoadQueue> queue = m_loadQueue;
+	std::shared_ptr<SoundBank> bank;
+	const char* data = nullptr;
+	size_t size = 0;
+	m_findInBanks(fname, bank, data, size);
+	PcmCache* cache = m_cache;
+	_DecodeOptions options = m_options;
+	m_workers->submit([queue, fname, bank, data, size, cache, options]() {
+		_DecodedAudio audio;
+		auto start = std::chrono::steady_clock::now();
+		if (!m_loadSource(fname, data, size, cache, options, nullptr, audio)) audio.data = nullptr; //a null data pointer tells processLoads the load failed
+		audio.decodeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->done.push_back(std::move(audio));
+	});
+	return load.future;
+}
+
+size_t AudioBuffer::processLoads(std::vector<LoadTiming>* timings)
+{
+	std::vector<_DecodedAudio> done;
+	{
+		std::lock_guard<std::mutex> lock(m_loadQueue->mutex);
+		if (m_loadQueue->done.empty()) return 0;
+		done.swap(m_loadQueue->done);
+	}
+	std::vector<ALuint> loaded;
+	for (auto& audio : done) {
+		ALuint sound = 0;
+		size_t bytes = audio.size;
+		auto start = std::chrono::steady_clock::now();
+		auto existing = buffers.find(audio.fname);
+		if (existing != buffers.end()) sound = existing->second; //somebody loaded it synchronously in the meantime
+		else if (audio.data) sound = m_upload(audio);
+		if (sound == 0) std::cerr << "Error loading on " << audio.fname << "!\n";
+		else loaded.push_back(sound);
+
+		if (timings) {
+			LoadTiming timing;
+			timing.fname = audio.fname;
+			timing.decodeMs = audio.decodeMs;
+			timing.uploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+			timing.bytes = bytes;
+			timing.savedBytes = audio.savedBytes;
+			timing.resampleMs = audio.resampleMs;
+			timing.resampleBytes = audio.resampleBytes;
+			timing.loaded = sound != 0;
+			timings->push_back(std::move(timing));
+		}
+
+		auto pending = m_pending.find(audio.fname);
+		if (pending != m_pending.end()) {
+			pending->second.promise.set_value(sound);
+			m_pending.erase(pending);
 		}
-		key = str;
-		break;
 	}
-	if (key == "") return false;
+	m_enforceBudget(loaded); //whoever asked for these gets a chance to acquire them before they're up for eviction
+	return done.size();
+}
 
-	buffers.erase(key);
+bool AudioBuffer::removeAudio(const ALuint& buf)
+{
+	if (m_entries.find(buf) == m_entries.end()) return false;
+	m_delete(buf);
 	return true;
 }
 
+void AudioBuffer::m_delete(ALuint buf)
+{
+	auto entry = m_entries.find(buf);
+	if (entry == m_entries.end()) return;
+
+	alGetError();
+	alDeleteBuffers(1, &buf);
+	auto err = alGetError();
+	if (err != AL_NO_ERROR) {
+		std::cerr << "Something went wrong on removing a buffer - error=" << err << std::endl;
+	}
+	if (entry->second.staticPcm) {
+		m_staticBytes -= std::min(m_staticBytes, entry->second.bytes);
+		if (err != AL_NO_ERROR) m_orphanedPcm.push_back(std::move(entry->second.staticPcm)); //OpenAL still has the buffer, so it might still read it
+	}
+	buffers.erase(entry->second.fname);
+	m_residentBytes -= std::min(m_residentBytes, entry->second.bytes);
+	m_entries.erase(entry);
+}
+
+AudioBuffer::~AudioBuffer()
+{
+	removeAllAudio();
+	//OpenAL wouldn't let go of these buffers, so it might still read their PCM. Leaking it beats OpenAL reading freed memory.
+	for (auto& pcm : m_orphanedPcm) pcm.release();
+}
+
 void AudioBuffer::removeAllAudio()
 {
 	for (auto& [key, val] : buffers) {
+		alGetError();
 		alDeleteBuffers(1, &val);
+		auto entry = m_entries.find(val);
+		if (alGetError() != AL_NO_ERROR && entry != m_entries.end() && entry->second.staticPcm) {
+			m_orphanedPcm.push_back(std::move(entry->second.staticPcm));
+		}
 	}
 	buffers.clear();
-}
\ No newline at end of file
+	m_entries.clear();
+	m_residentBytes = 0;
+	m_staticBytes = 0;
+}
+
+float AudioBuffer::getLength(const ALuint& buf) const
+{
+	auto it = m_entries.find(buf);
+	if (it == m_entries.end()) return 0.f;
+	return it->second.length;
+}
+
+void AudioBuffer::acquire(const ALuint& buf, bool countHit)
+{
+	auto it = m_entries.find(buf);
+	if (it == m_entries.end()) return;
+	++it->second.refs;
+	it->second.lastUse = ++m_useCounter;
+	if (countHit) ++m_hits;
+}
+
+void AudioBuffer::release(const ALuint& buf)
+{
+	auto it = m_entries.find(buf);
+	if (it == m_entries.end() || it->second.refs == 0) return;
+	--it->second.refs;
+	it->second.lastUse = ++m_useCounter;
+	if (it->second.refs == 0 && m_budget > 0 && m_residentBytes > m_budget) m_enforceBudget({});
+}
+
+void AudioBuffer::pin(const std::string& fname, bool pinned)
+{
+	if (pinned) m_pinned.insert(fname);
+	else {
+		m_pinned.erase(fname);
+		m_enforceBudget({});
+	}
+}
+
+void AudioBuffer::setBudget(size_t bytes)
+{
+	m_budget = bytes;
+	m_enforceBudget({});
+}
+
+void AudioBuffer::m_enforceBudget(const std::vector<ALuint>& keep)
+{
+	while (m_budget > 0 && m_residentBytes > m_budget) {
+		ALuint victim = 0;
+		uint64_t oldest = UINT64_MAX;
+		for (const auto& [buf, entry] : m_entries) {
+			if (entry.refs > 0 || entry.lastUse >= oldest) continue;
+			if (m_pinned.find(entry.fname) != m_pinned.end()) continue;
+			if (std::find(keep.begin(), keep.end(), buf) != keep.end()) continue;
+			victim = buf;
+			oldest = entry.lastUse;
+		}
+		if (victim == 0) return; //everything left is playing or pinned
+
+		m_delete(victim);
+		++m_evictions;
+		if (m_onEvict) m_onEvict(victim);
+	}
+}
+
+AudioBuffer::CacheStats AudioBuffer::getCacheStats() const
+{
+	CacheStats stats;
+	stats.residentBytes = m_residentBytes;
+	stats.budget = m_budget;
+	stats.buffers = m_entries.size();
+	stats.evictions = m_evictions;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.staticBytes = m_staticBytes;
+	stats.downmixSavedBytes = m_downmixSavedBytes;
+	stats.resampled = m_resampled;
+	stats.resampleBytes = m_resampleBytes;
+	return stats;
+}
@@ -0,0 +1,139 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "AudioExtensions.h"
+#include <stdio.h>
+
+AudioExtensions::~AudioExtensions()
+{
+	stopSourceEvents();
+}
+
+void AudioExtensions::load(ALCcontext* context)
+{
+	m_context = context;
+	if (!context) return;
+
+	if (alIsExtensionPresent("AL_SOFT_deferred_updates")) {
+		m_deferUpdates = (LPALDEFERUPDATESSOFT)alGetProcAddress("alDeferUpdatesSOFT");
+		m_processUpdates = (LPALPROCESSUPDATESSOFT)alGetProcAddress("alProcessUpdatesSOFT");
+		if (!m_deferUpdates || !m_processUpdates) {
+			m_deferUpdates = nullptr;
+			m_processUpdates = nullptr;
+		}
+	}
+	m_sourceSpatialize = alIsExtensionPresent("AL_SOFT_source_spatialize") == AL_TRUE;
+	m_float32 = alIsExtensionPresent("AL_EXT_FLOAT32") == AL_TRUE;
+	if (alIsExtensionPresent("AL_EXT_STATIC_BUFFER")) {
+		m_bufferDataStatic = (PFNALBUFFERDATASTATICPROC)alGetProcAddress("alBufferDataStatic");
+	}
+	if (alIsExtensionPresent("AL_SOFT_map_buffer")) {
+		m_bufferStorage = (LPALBUFFERSTORAGESOFT)alGetProcAddress("alBufferStorageSOFT");
+		m_mapBuffer = (LPALMAPBUFFERSOFT)alGetProcAddress("alMapBufferSOFT");
+		m_unmapBuffer = (LPALUNMAPBUFFERSOFT)alGetProcAddress("alUnmapBufferSOFT");
+		if (!m_bufferStorage || !m_mapBuffer || !m_unmapBuffer) {
+			m_bufferStorage = nullptr;
+			m_mapBuffer = nullptr;
+			m_unmapBuffer = nullptr;
+		}
+	}
+	if (alIsExtensionPresent("AL_SOFT_events")) {
+		m_eventControl = (LPALEVENTCONTROLSOFT)alGetProcAddress("alEventControlSOFT");
+		m_eventCallbackFunc = (LPALEVENTCALLBACKSOFT)alGetProcAddress("alEventCallbackSOFT");
+	}
+	printf("Deferred updates: %s \n", hasDeferredUpdates() ? "AL_SOFT_deferred_updates" : "context suspend");
+	printf("Buffer uploads: %s \n", hasStaticBuffers() ? "AL_EXT_STATIC_BUFFER" : hasMapBuffer() ? "AL_SOFT_map_buffer" : "copy");
+}
+
+bool AudioExtensions::bufferDataStatic(ALuint buffer, ALenum format, void* data, ALsizei size, ALsizei rate) const
+{
+	if (!m_bufferDataStatic) return false;
+	alGetError();
+	m_bufferDataStatic((ALint)buffer, format, data, size, rate);
+	return alGetError() == AL_NO_ERROR;
+}
+
+void* AudioExtensions::mapNewBuffer(ALuint buffer, ALenum format, ALsizei size, ALsizei rate) const
+{
+	if (!m_mapBuffer) return nullptr;
+	const ALbitfieldSOFT access = AL_MAP_READ_BIT_SOFT | AL_MAP_WRITE_BIT_SOFT; //read too, so the PCM cache can save what got decoded
+	alGetError();
+	m_bufferStorage(buffer, format, nullptr, size, rate, access);
+	if (alGetError() != AL_NO_ERROR) return nullptr;
+	void* data = m_mapBuffer(buffer, 0, size, access);
+	if (alGetError() != AL_NO_ERROR) return nullptr;
+	return data;
+}
+
+void AudioExtensions::unmapBuffer(ALuint buffer) const
+{
+	if (m_unmapBuffer) m_unmapBuffer(buffer);
+}
+
+void AudioExtensions::beginBatch()
+{
+	if (m_inBatch || !m_context) return;
+	m_inBatch = true;
+	if (m_deferUpdates) m_deferUpdates();
+	else alcSuspendContext(m_context);
+}
+
+void AudioExtensions::endBatch()
+{
+	if (!m_inBatch) return;
+	m_inBatch = false;
+	if (m_processUpdates) m_processUpdates();
+	else alcProcessContext(m_context);
+}
+
+bool AudioExtensions::startSourceEvents()
+{
+	if (m_eventsStarted) return true;
+	if (!m_eventControl || !m_eventCallbackFunc) return false;
+
+	alGetError();
+	m_eventCallbackFunc(m_eventCallback, this);
+	const ALenum types[] = { AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT };
+	m_eventControl(1, types, AL_TRUE);
+	if (alGetError() != AL_NO_ERROR) {
+		m_eventCallbackFunc(nullptr, nullptr);
+		return false;
+	}
+	m_eventsStarted = true;
+	printf("Source completion: AL_SOFT_events \n");
+	return true;
+}
+
+void AudioExtensions::stopSourceEvents()
+{
+	if (!m_eventsStarted) return;
+	const ALenum types[] = { AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT };
+	m_eventControl(1, types, AL_FALSE);
+	m_eventCallbackFunc(nullptr, nullptr);
+	m_eventsStarted = false;
+}
+
+void AL_APIENTRY AudioExtensions::m_eventCallback(ALenum eventType, ALuint object, ALuint param, ALsizei /*length*/, const ALchar* /*message*/, void* userParam)
+{
+	if (eventType != AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT || param != AL_STOPPED) return;
+
+	AudioExtensions* ext = (AudioExtensions*)userParam;
+	if (!ext->m_stoppedSources.push(object)) ext->m_overflow = true;
+}
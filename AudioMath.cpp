@@ -0,0 +1,452 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "AudioMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AUDIOMATH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AUDIOMATH_AVX2
+#else
+#define AUDIOMATH_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define AUDIOMATH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+	typedef void (*AudibilityKernel)(const EmitterArrays&, const AlVec3f&, float, float, float*, uint8_t*, float*);
+	typedef void (*FloatKernel)(const float* const*, int, size_t, float*);
+	typedef void (*Int16Kernel)(const float* const*, int, size_t, int16_t*);
+
+	//Handles emitters from start to the end of the arrays one at a time. Also mops up whatever's left over after the vector loops.
+	void audibilityFrom(const EmitterArrays& e, const AlVec3f& listener, float gainScale, float cullDistSq,
+		float* audibility, uint8_t* cull, float* distance, size_t start)
+	{
+		for (size_t i = start; i < e.count; ++i) {
+			float dx = e.posX[i] - listener.x;
+			float dy = e.posY[i] - listener.y;
+			float dz = e.posZ[i] - listener.z;
+			float distSq = dx * dx + dy * dy + dz * dz;
+			float dist = std::sqrt(distSq);
+			float atten = 1.f;
+			float range = e.maxDist[i] - e.refDist[i];
+			if (range > 0.f) atten = 1.f - (std::clamp(dist, e.refDist[i], e.maxDist[i]) - e.refDist[i]) / range;
+
+			uint8_t flags = EMITTER_AUDIBLE;
+			if (range > 0.f && dist >= e.maxDist[i]) flags |= EMITTER_OUT_OF_RANGE;
+			if (cullDistSq > 0.f && distSq >= cullDistSq) flags |= EMITTER_TOO_FAR;
+			audibility[i] = flags ? 0.f : e.gain[i] * gainScale * atten;
+			cull[i] = flags;
+			if (distance) distance[i] = dist;
+		}
+	}
+
+#ifdef AUDIOMATH_X86
+	void sse2Audibility(const EmitterArrays& e, const AlVec3f& listener, float gainScale, float cullDistSq,
+		float* audibility, uint8_t* cull, float* distance)
+	{
+		const __m128 lx = _mm_set1_ps(listener.x), ly = _mm_set1_ps(listener.y), lz = _mm_set1_ps(listener.z);
+		const __m128 scale = _mm_set1_ps(gainScale), cullSq = _mm_set1_ps(cullDistSq);
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+		const __m128 cullOn = cullDistSq > 0.f ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+		size_t i = 0;
+		for (; i + 4 <= e.count; i += 4) {
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(e.posX + i), lx);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(e.posY + i), ly);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(e.posZ + i), lz);
+			__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 dist = _mm_sqrt_ps(distSq);
+			__m128 ref = _mm_loadu_ps(e.refDist + i), max = _mm_loadu_ps(e.maxDist + i);
+			__m128 range = _mm_sub_ps(max, ref);
+			__m128 ranged = _mm_cmpgt_ps(range, zero);
+			//lanes without a usable range divide by one instead and get their attenuation forced to one below
+			__m128 t = _mm_div_ps(_mm_sub_ps(_mm_min_ps(_mm_max_ps(dist, ref), max), ref),
+				_mm_or_ps(_mm_and_ps(ranged, range), _mm_andnot_ps(ranged, one)));
+			__m128 atten = _mm_sub_ps(one, _mm_and_ps(ranged, t));
+
+			__m128 outOfRange = _mm_and_ps(ranged, _mm_cmpge_ps(dist, max));
+			__m128 tooFar = _mm_and_ps(cullOn, _mm_cmpge_ps(distSq, cullSq));
+			__m128 gain = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(e.gain + i), scale), atten);
+			_mm_storeu_ps(audibility + i, _mm_andnot_ps(_mm_or_ps(outOfRange, tooFar), gain));
+			if (distance) _mm_storeu_ps(distance + i, dist);
+
+			int far = _mm_movemask_ps(outOfRange), cut = _mm_movemask_ps(tooFar);
+			for (int lane = 0; lane < 4; ++lane) {
+				cull[i + lane] = (uint8_t)(((far >> lane) & 1) * EMITTER_OUT_OF_RANGE | ((cut >> lane) & 1) * EMITTER_TOO_FAR);
+			}
+		}
+		audibilityFrom(e, listener, gainScale, cullDistSq, audibility, cull, distance, i);
+	}
+
+	AUDIOMATH_AVX2 void avx2Audibility(const EmitterArrays& e, const AlVec3f& listener, float gainScale, float cullDistSq,
+		float* audibility, uint8_t* cull, float* distance)
+	{
+		const __m256 lx = _mm256_set1_ps(listener.x), ly = _mm256_set1_ps(listener.y), lz = _mm256_set1_ps(listener.z);
+		const __m256 scale = _mm256_set1_ps(gainScale), cullSq = _mm256_set1_ps(cullDistSq);
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+		const __m256 cullOn = cullDistSq > 0.f ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : zero;
+		size_t i = 0;
+		for (; i + 8 <= e.count; i += 8) {
+			__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(e.posX + i), lx);
+			__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(e.posY + i), ly);
+			__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(e.posZ + i), lz);
+			__m256 distSq = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+			__m256 dist = _mm256_sqrt_ps(distSq);
+			__m256 ref = _mm256_loadu_ps(e.refDist + i), max = _mm256_loadu_ps(e.maxDist + i);
+			__m256 range = _mm256_sub_ps(max, ref);
+			__m256 ranged = _mm256_cmp_ps(range, zero, _CMP_GT_OQ);
+			__m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(dist, ref), max), ref), _mm256_blendv_ps(one, range, ranged));
+			__m256 atten = _mm256_sub_ps(one, _mm256_and_ps(ranged, t));
+
+			__m256 outOfRange = _mm256_and_ps(ranged, _mm256_cmp_ps(dist, max, _CMP_GE_OQ));
+			__m256 tooFar = _mm256_and_ps(cullOn, _mm256_cmp_ps(distSq, cullSq, _CMP_GE_OQ));
+			__m256 gain = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(e.gain + i), scale), atten);
+			_mm256_storeu_ps(audibility + i, _mm256_andnot_ps(_mm256_or_ps(outOfRange, tooFar), gain));
+			if (distance) _mm256_storeu_ps(distance + i, dist);
+
+			//pack the two masks down into one byte per emitter: bit 0 is out of range, bit 1 is too far
+			__m256i flags = _mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(outOfRange), _mm256_set1_epi32(EMITTER_OUT_OF_RANGE)),
+				_mm256_and_si256(_mm256_castps_si256(tooFar), _mm256_set1_epi32(EMITTER_TOO_FAR)));
+			__m128i words = _mm_packs_epi32(_mm256_castsi256_si128(flags), _mm256_extracti128_si256(flags, 1));
+			_mm_storel_epi64((__m128i*)(cull + i), _mm_packus_epi16(words, words));
+		}
+		audibilityFrom(e, listener, gainScale, cullDistSq, audibility, cull, distance, i);
+	}
+
+	bool hasAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+		__cpuid(info, 1);
+		bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		bool fma = (info[2] & (1 << 12)) != 0;
+		__cpuidex(info, 7, 0);
+		return osSavesYmm && fma && (info[1] & (1 << 5));
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+#endif
+
+	//Interleaves frames from start onwards one sample at a time. Also mops up after the vector loops, and handles anything over 2 channels.
+	void interleaveFloatFrom(const float* const* planes, int channels, size_t frames, float* out, size_t start)
+	{
+		if (channels == 1) {
+			if (frames > start) memcpy(out + start, planes[0] + start, (frames - start) * sizeof(float));
+			return;
+		}
+		for (size_t f = start; f < frames; ++f) {
+			for (int c = 0; c < channels; ++c) out[f * channels + c] = planes[c][f];
+		}
+	}
+	int16_t toInt16(float sample)
+	{
+		long value = std::lrintf(sample * 32768.f);
+		return (int16_t)std::min(std::max(value, -32768L), 32767L);
+	}
+	//Averages every channel into one from frame start onwards.
+	void downmixFrom(const float* const* planes, int channels, size_t frames, float* out, size_t start)
+	{
+		const float scale = 1.f / (float)channels;
+		for (size_t f = start; f < frames; ++f) {
+			float sum = planes[0][f];
+			for (int c = 1; c < channels; ++c) sum += planes[c][f];
+			out[f] = sum * scale;
+		}
+	}
+	void interleaveInt16From(const float* const* planes, int channels, size_t frames, int16_t* out, size_t start)
+	{
+		for (size_t f = start; f < frames; ++f) {
+			for (int c = 0; c < channels; ++c) out[f * channels + c] = toInt16(planes[c][f]);
+		}
+	}
+
+#ifdef AUDIOMATH_X86
+	//Scales, clips and rounds 8 floats into 8 int16 samples.
+	__m128i sse2ToInt16(__m128 a, __m128 b)
+	{
+		const __m128 scale = _mm_set1_ps(32768.f), hi = _mm_set1_ps(32767.f), lo = _mm_set1_ps(-32768.f);
+		__m128i ia = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(a, scale), hi), lo));
+		__m128i ib = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(b, scale), hi), lo));
+		return _mm_packs_epi32(ia, ib);
+	}
+
+	void sse2InterleaveFloat(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		size_t f = 0;
+		if (channels == 2) {
+			const float* l = planes[0];
+			const float* r = planes[1];
+			for (; f + 4 <= frames; f += 4) {
+				__m128 a = _mm_loadu_ps(l + f), b = _mm_loadu_ps(r + f);
+				_mm_storeu_ps(out + f * 2, _mm_unpacklo_ps(a, b));
+				_mm_storeu_ps(out + f * 2 + 4, _mm_unpackhi_ps(a, b));
+			}
+		}
+		interleaveFloatFrom(planes, channels, frames, out, f);
+	}
+
+	void sse2InterleaveInt16(const float* const* planes, int channels, size_t frames, int16_t* out)
+	{
+		size_t f = 0;
+		if (channels == 1) {
+			const float* m = planes[0];
+			for (; f + 8 <= frames; f += 8) _mm_storeu_si128((__m128i*)(out + f), sse2ToInt16(_mm_loadu_ps(m + f), _mm_loadu_ps(m + f + 4)));
+		}
+		else if (channels == 2) {
+			const float* l = planes[0];
+			const float* r = planes[1];
+			for (; f + 4 <= frames; f += 4) {
+				__m128 a = _mm_loadu_ps(l + f), b = _mm_loadu_ps(r + f);
+				_mm_storeu_si128((__m128i*)(out + f * 2), sse2ToInt16(_mm_unpacklo_ps(a, b), _mm_unpackhi_ps(a, b)));
+			}
+		}
+		interleaveInt16From(planes, channels, frames, out, f);
+	}
+
+	void sse2Downmix(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		const __m128 scale = _mm_set1_ps(1.f / (float)channels);
+		size_t f = 0;
+		for (; f + 4 <= frames; f += 4) {
+			__m128 sum = _mm_loadu_ps(planes[0] + f);
+			for (int c = 1; c < channels; ++c) sum = _mm_add_ps(sum, _mm_loadu_ps(planes[c] + f));
+			_mm_storeu_ps(out + f, _mm_mul_ps(sum, scale));
+		}
+		downmixFrom(planes, channels, frames, out, f);
+	}
+
+	//Scales, clips and rounds 16 floats into 16 int16 samples, in order.
+	AUDIOMATH_AVX2 __m256i avx2ToInt16(__m256 a, __m256 b)
+	{
+		const __m256 scale = _mm256_set1_ps(32768.f), hi = _mm256_set1_ps(32767.f), lo = _mm256_set1_ps(-32768.f);
+		__m256i ia = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(a, scale), hi), lo));
+		__m256i ib = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(b, scale), hi), lo));
+		return _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xD8); //the pack works per 128-bit lane, so put the quarters back in order
+	}
+
+	//Interleaves 8 frames of stereo into two registers of L R pairs.
+	AUDIOMATH_AVX2 void avx2Zip(__m256 l, __m256 r, __m256& first, __m256& second)
+	{
+		__m256 lo = _mm256_unpacklo_ps(l, r), hi = _mm256_unpackhi_ps(l, r);
+		first = _mm256_permute2f128_ps(lo, hi, 0x20);
+		second = _mm256_permute2f128_ps(lo, hi, 0x31);
+	}
+
+	AUDIOMATH_AVX2 void avx2InterleaveFloat(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		size_t f = 0;
+		if (channels == 2) {
+			const float* l = planes[0];
+			const float* r = planes[1];
+			for (; f + 8 <= frames; f += 8) {
+				__m256 first, second;
+				avx2Zip(_mm256_loadu_ps(l + f), _mm256_loadu_ps(r + f), first, second);
+				_mm256_storeu_ps(out + f * 2, first);
+				_mm256_storeu_ps(out + f * 2 + 8, second);
+			}
+		}
+		interleaveFloatFrom(planes, channels, frames, out, f);
+	}
+
+	AUDIOMATH_AVX2 void avx2Downmix(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		const __m256 scale = _mm256_set1_ps(1.f / (float)channels);
+		size_t f = 0;
+		for (; f + 8 <= frames; f += 8) {
+			__m256 sum = _mm256_loadu_ps(planes[0] + f);
+			for (int c = 1; c < channels; ++c) sum = _mm256_add_ps(sum, _mm256_loadu_ps(planes[c] + f));
+			_mm256_storeu_ps(out + f, _mm256_mul_ps(sum, scale));
+		}
+		downmixFrom(planes, channels, frames, out, f);
+	}
+
+	AUDIOMATH_AVX2 void avx2InterleaveInt16(const float* const* planes, int channels, size_t frames, int16_t* out)
+	{
+		size_t f = 0;
+		if (channels == 1) {
+			const float* m = planes[0];
+			for (; f + 16 <= frames; f += 16) {
+				_mm256_storeu_si256((__m256i*)(out + f), avx2ToInt16(_mm256_loadu_ps(m + f), _mm256_loadu_ps(m + f + 8)));
+			}
+		}
+		else if (channels == 2) {
+			const float* l = planes[0];
+			const float* r = planes[1];
+			for (; f + 8 <= frames; f += 8) {
+				__m256 first, second;
+				avx2Zip(_mm256_loadu_ps(l + f), _mm256_loadu_ps(r + f), first, second);
+				_mm256_storeu_si256((__m256i*)(out + f * 2), avx2ToInt16(first, second));
+			}
+		}
+		interleaveInt16From(planes, channels, frames, out, f);
+	}
+#endif
+
+#ifdef AUDIOMATH_NEON
+	//Scales, clips and rounds 4 floats into 4 int16 samples. The narrowing saturates, so only the rounding needs doing by hand.
+	int16x4_t neonToInt16(float32x4_t a)
+	{
+		return vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(a, 32768.f)));
+	}
+
+	void neonInterleaveFloat(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		size_t f = 0;
+		if (channels == 2) {
+			const float* l = planes[0];
+			const float* r = planes[1];
+			for (; f + 4 <= frames; f += 4) {
+				float32x4x2_t pair = { { vld1q_f32(l + f), vld1q_f32(r + f) } };
+				vst2q_f32(out + f * 2, pair);
+			}
+		}
+		interleaveFloatFrom(planes, channels, frames, out, f);
+	}
+
+	void neonDownmix(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		const float scale = 1.f / (float)channels;
+		size_t f = 0;
+		for (; f + 4 <= frames; f += 4) {
+			float32x4_t sum = vld1q_f32(planes[0] + f);
+			for (int c = 1; c < channels; ++c) sum = vaddq_f32(sum, vld1q_f32(planes[c] + f));
+			vst1q_f32(out + f, vmulq_n_f32(sum, scale));
+		}
+		downmixFrom(planes, channels, frames, out, f);
+	}
+
+	void neonInterleaveInt16(const float* const* planes, int channels, size_t frames, int16_t* out)
+	{
+		size_t f = 0;
+		if (channels == 1) {
+			const float* m = planes[0];
+			for (; f + 4 <= frames; f += 4) vst1_s16(out + f, neonToInt16(vld1q_f32(m + f)));
+		}
+		else if (channels == 2) {
+			const float* l = planes[0];
+			const float* r = planes[1];
+			for (; f + 4 <= frames; f += 4) {
+				int16x4x2_t pair = { { neonToInt16(vld1q_f32(l + f)), neonToInt16(vld1q_f32(r + f)) } };
+				vst2_s16(out + f * 2, pair);
+			}
+		}
+		interleaveInt16From(planes, channels, frames, out, f);
+	}
+#endif
+
+	void scalarInterleaveFloat(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		interleaveFloatFrom(planes, channels, frames, out, 0);
+	}
+	void scalarInterleaveInt16(const float* const* planes, int channels, size_t frames, int16_t* out)
+	{
+		interleaveInt16From(planes, channels, frames, out, 0);
+	}
+	void scalarDownmix(const float* const* planes, int channels, size_t frames, float* out)
+	{
+		downmixFrom(planes, channels, frames, out, 0);
+	}
+
+	void scalarAudibility(const EmitterArrays& e, const AlVec3f& listener, float gainScale, float cullDistSq,
+		float* audibility, uint8_t* cull, float* distance)
+	{
+		audibilityFrom(e, listener, gainScale, cullDistSq, audibility, cull, distance, 0);
+	}
+
+	struct Dispatch {
+		AudibilityKernel audibility = scalarAudibility;
+		FloatKernel interleaveFloat = scalarInterleaveFloat;
+		Int16Kernel interleaveInt16 = scalarInterleaveInt16;
+		FloatKernel downmix = scalarDownmix;
+		const char* name = "scalar";
+		Dispatch()
+		{
+#ifdef AUDIOMATH_X86
+			if (hasAVX2()) {
+				audibility = avx2Audibility;
+				interleaveFloat = avx2InterleaveFloat;
+				interleaveInt16 = avx2InterleaveInt16;
+				downmix = avx2Downmix;
+				name = "AVX2";
+			}
+			else { //every x86 CPU that can run a 64-bit OS has SSE2
+				audibility = sse2Audibility;
+				interleaveFloat = sse2InterleaveFloat;
+				interleaveInt16 = sse2InterleaveInt16;
+				downmix = sse2Downmix;
+				name = "SSE2";
+			}
+#elif defined(AUDIOMATH_NEON)
+			interleaveFloat = neonInterleaveFloat; //NEON is always there on 64-bit ARM
+			interleaveInt16 = neonInterleaveInt16;
+			downmix = neonDownmix;
+			name = "NEON";
+#endif
+		}
+	};
+
+	const Dispatch& dispatch()
+	{
+		static const Dispatch chosen;
+		return chosen;
+	}
+}
+
+void computeAudibility(const EmitterArrays& emitters, const AlVec3f& listener, float gainScale, float cullDistSq,
+	float* audibility, uint8_t* cull, float* distance)
+{
+	dispatch().audibility(emitters, listener, gainScale, cullDistSq, audibility, cull, distance);
+}
+
+void computeAudibilityScalar(const EmitterArrays& emitters, const AlVec3f& listener, float gainScale, float cullDistSq,
+	float* audibility, uint8_t* cull, float* distance)
+{
+	scalarAudibility(emitters, listener, gainScale, cullDistSq, audibility, cull, distance);
+}
+
+void interleaveFloat(const float* const* planes, int channels, size_t frames, float* out)
+{
+	dispatch().interleaveFloat(planes, channels, frames, out);
+}
+
+void interleaveInt16(const float* const* planes, int channels, size_t frames, int16_t* out)
+{
+	dispatch().interleaveInt16(planes, channels, frames, out);
+}
+
+void downmixToMono(const float* const* planes, int channels, size_t frames, float* out)
+{
+	dispatch().downmix(planes, channels, frames, out);
+}
+
+const char* audioMathPath()
+{
+	return dispatch().name;
+}
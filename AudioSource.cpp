@@ -21,10 +21,19 @@
 #include "AudioSource.h"
 #include <iostream>
 
+float AudioSource::s_epsilon = 0.f;
+AudioSource::CallStats AudioSource::s_callStats;
+
 AudioSource::AudioSource()
 {
 	alGetError();
 	alGenSources(1, &source);
+	if (alGetError() != AL_NO_ERROR) {
+		std::cerr << "Could not generate source!\n";
+		source = 0;
+		return;
+	}
+	m_valid = true;
 	alSourcef(source, AL_PITCH, m_pitch);
 	alSourcef(source, AL_GAIN, m_gain);
 	alSource3f(source, AL_POSITION, m_position[0], m_position[1], m_position[2]);
@@ -32,18 +41,19 @@ AudioSource::AudioSource()
 	alSourcei(source, AL_LOOPING, m_loop);
 	alSourcei(source, AL_BUFFER, buf);
 
-	alSourcef(source, AL_REFERENCE_DISTANCE, m_maxDist);
-	alSourcef(source, AL_MAX_DISTANCE, m_refDist);
+	alSourcef(source, AL_REFERENCE_DISTANCE, m_refDist);
+	alSourcef(source, AL_MAX_DISTANCE, m_maxDist);
 	//alSourcef(source, AL_ROLLOFF_FACTOR, .5f);
 	alSourcei(source, AL_SOURCE_RELATIVE, false);
 }
 AudioSource::~AudioSource()
 {
+	if (!m_valid) return;
 	alGetError();
 	alSourcei(source, AL_BUFFER, 0); //detach the buffer, if it exists
 	alDeleteSources(1, &source); //get rid of the source
 }
-void AudioSource::play(const ALuint bufToPlay)
+void AudioSource::play(const ALuint bufToPlay, const float offset)
 {
 	if (buf != 0) stop();
 
@@ -53,19 +63,19 @@ void AudioSource::play(const ALuint bufToPlay)
 	if (err = alGetError() != AL_NO_ERROR) {
 		std::cerr << "Could not attach buffer to source - error " << err << std::endl;
 	}
-	setPitch(m_pitch);
-	setGain(m_gain);
-	alSource3f(source, AL_POSITION, m_position[0], m_position[1], m_position[2]);
-	alSource3f(source, AL_VELOCITY, m_velocity[0], m_velocity[1], m_velocity[2]);
-	alSourcei(source, AL_LOOPING, m_loop);
+	flush();
 
 	//alSourcef(source, AL_MAX_DISTANCE, 100.f);
 	//alSourcef(source, AL_REFERENCE_DISTANCE, 100.f);
 
+	if (offset > 0.f) alSourcef(source, AL_SEC_OFFSET, offset);
+
 	err = alGetError();
 	alSourcePlay(source);
+	m_stopped = false;
 	if (err = alGetError() != AL_NO_ERROR) {
 		std::cerr << "Could not play source!\n";
+		m_stopped = true; //no stop event is ever coming for this one
 	}
 }
 
@@ -77,35 +87,73 @@ void AudioSource::stop()
 	alSourcei(source, AL_BUFFER, 0);
 }
 
+void AudioSource::m_set(float& current, const float value, const DirtyBits bit)
+{
+	if (std::abs(value - current) <= s_epsilon) {
+		++s_callStats.saved;
+		return;
+	}
+	if (m_dirty & bit) ++s_callStats.saved; //the earlier change never made it out, so this one replaces it for free
+	current = value;
+	m_dirty |= bit;
+}
+void AudioSource::m_set(float* current, const float* value, const DirtyBits bit)
+{
+	if (std::abs(value[0] - current[0]) <= s_epsilon && std::abs(value[1] - current[1]) <= s_epsilon && std::abs(value[2] - current[2]) <= s_epsilon) {
+		++s_callStats.saved;
+		return;
+	}
+	if (m_dirty & bit) ++s_callStats.saved;
+	current[0] = value[0];
+	current[1] = value[1];
+	current[2] = value[2];
+	m_dirty |= bit;
+}
 void AudioSource::setPos(const AlVec3f pos) {
-	m_position[0] = pos.x;
-	m_position[1] = pos.y;
-	m_position[2] = -pos.z;
-	auto err = alGetError();
-	alSourcefv(source, AL_POSITION, m_position);
+	const float position[3] = { pos.x, pos.y, -pos.z };
+	m_set(m_position, position, DIRTY_POSITION);
 }
 void AudioSource::setVel(const AlVec3f vel) {
-	m_velocity[0] = vel.x;
-	m_velocity[1] = vel.y;
-	m_velocity[2] = -vel.z;
-	alGetError();
-	alSourcefv(source, AL_VELOCITY, m_velocity);
+	const float velocity[3] = { vel.x, vel.y, -vel.z };
+	m_set(m_velocity, velocity, DIRTY_VELOCITY);
 }
 void AudioSource::setPitch(const float pitch)
 {
-	m_pitch = pitch;
-	alSourcef(source, AL_PITCH, m_pitch);
-
+	m_set(m_pitch, pitch, DIRTY_PITCH);
 }
 void AudioSource::setGain(const float gain)
 {
-	m_gain = gain;
-	alSourcef(source, AL_GAIN, m_gain);
+	m_set(m_gain, gain, DIRTY_GAIN);
 }
 void AudioSource::setLoop(const bool loop)
 {
+	if (loop == m_loop) {
+		++s_callStats.saved;
+		return;
+	}
+	if (m_dirty & DIRTY_LOOP) ++s_callStats.saved;
 	m_loop = loop;
-	alSourcei(source, AL_LOOPING, m_loop);
+	m_dirty |= DIRTY_LOOP;
+}
+void AudioSource::setRelative(const bool relative)
+{
+	if (relative == m_relative) {
+		++s_callStats.saved;
+		return;
+	}
+	if (m_dirty & DIRTY_RELATIVE) ++s_callStats.saved;
+	m_relative = relative;
+	m_dirty |= DIRTY_RELATIVE;
+}
+void AudioSource::setSpatialize(const ALint mode)
+{
+	if (mode == m_spatialize) {
+		++s_callStats.saved;
+		return;
+	}
+	if (m_dirty & DIRTY_SPATIALIZE) ++s_callStats.saved;
+	m_spatialize = mode;
+	m_dirty |= DIRTY_SPATIALIZE;
 }
 const bool AudioSource::isLooping()
 {
@@ -113,14 +161,39 @@ const bool AudioSource::isLooping()
 }
 void AudioSource::setMaxDist(const float dist)
 {
-	m_maxDist = dist;
-	alSourcef(source, AL_MAX_DISTANCE, m_maxDist);
+	m_set(m_maxDist, dist, DIRTY_MAX_DIST);
 }
 
 void AudioSource::setRefDist(const float dist)
 {
-	m_refDist = dist;
-	alSourcef(source, AL_REFERENCE_DISTANCE, m_refDist);
+	m_set(m_refDist, dist, DIRTY_REF_DIST);
+}
+
+void AudioSource::flush()
+{
+	if (!m_dirty) return;
+
+	if (m_dirty & DIRTY_PITCH) alSourcef(source, AL_PITCH, m_pitch);
+	if (m_dirty & DIRTY_GAIN) alSourcef(source, AL_GAIN, m_gain);
+	if (m_dirty & DIRTY_POSITION) alSourcefv(source, AL_POSITION, m_position);
+	if (m_dirty & DIRTY_VELOCITY) alSourcefv(source, AL_VELOCITY, m_velocity);
+	if (m_dirty & DIRTY_LOOP) alSourcei(source, AL_LOOPING, m_loop);
+	if (m_dirty & DIRTY_MAX_DIST) alSourcef(source, AL_MAX_DISTANCE, m_maxDist);
+	if (m_dirty & DIRTY_REF_DIST) alSourcef(source, AL_REFERENCE_DISTANCE, m_refDist);
+	if (m_dirty & DIRTY_RELATIVE) alSourcei(source, AL_SOURCE_RELATIVE, m_relative);
+	if (m_dirty & DIRTY_SPATIALIZE) alSourcei(source, AL_SOURCE_SPATIALIZE_SOFT, m_spatialize);
+
+	for (uint16_t bits = m_dirty; bits; bits &= bits - 1) ++s_callStats.issued;
+	m_dirty = 0;
+}
+
+float AudioSource::getOffset()
+{
+	if (buf == 0) return 0.f;
+
+	ALfloat offset = 0.f;
+	alGetSourcef(source, AL_SEC_OFFSET, &offset);
+	return offset;
 }
 
 bool AudioSource::isFinished()
@@ -133,4 +206,17 @@ bool AudioSource::isFinished()
 	if (state != AL_PLAYING) return true;
 
 	return false;
-}
\ No newline at end of file
+}
+void AudioSource::reset()
+{
+	stop();
+	setPitch(1.f);
+	setGain(.7f);
+	setPos(AlVec3f(0, 0, 0));
+	setVel(AlVec3f(0, 0, 0));
+	setLoop(false);
+	setMaxDist(100.f);
+	setRefDist(10.f);
+	setRelative(false);
+	setSpatialize(AL_AUTO_SOFT);
+}
@@ -0,0 +1,113 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "AudioSourcePool.h"
+#include <iostream>
+
+AudioSourcePool::~AudioSourcePool()
+{
+	clear();
+}
+
+size_t AudioSourcePool::init(const size_t initialSize, const size_t maxSize)
+{
+	clear();
+	m_maxSize = maxSize < initialSize ? initialSize : maxSize;
+	m_sources.reserve(m_maxSize);
+	m_free.reserve(m_maxSize);
+	for (size_t i = 0; i < initialSize; ++i) {
+		AudioSource* src = m_generate();
+		if (!src) {
+			std::cerr << "Source pool could only generate " << i << " of " << initialSize << " sources.\n";
+			break;
+		}
+		m_free.push_back(src);
+	}
+	return m_sources.size();
+}
+
+AudioSource* AudioSourcePool::m_generate()
+{
+	if (m_sources.size() >= m_maxSize) return nullptr;
+
+	auto src = std::make_unique<AudioSource>();
+	if (!src->isValid()) return nullptr;
+
+	m_byId[src->getId()] = src.get();
+	m_sources.push_back(std::move(src));
+	m_stats.capacity = m_sources.size();
+	return m_sources.back().get();
+}
+
+AudioSource* AudioSourcePool::acquire()
+{
+	AudioSource* src = nullptr;
+	if (!m_free.empty()) {
+		src = m_free.back();
+		m_free.pop_back();
+		++m_stats.hits;
+	}
+	else {
+		src = m_generate();
+		if (!src) {
+			++m_stats.exhausted;
+			return nullptr;
+		}
+		++m_stats.misses;
+	}
+	++m_stats.inUse;
+	if (m_stats.inUse > m_stats.peakInUse) m_stats.peakInUse = m_stats.inUse;
+	return src;
+}
+
+void AudioSourcePool::release(AudioSource* src)
+{
+	if (!src) return;
+	src->reset();
+	m_free.push_back(src);
+	if (m_stats.inUse > 0) --m_stats.inUse;
+}
+
+void AudioSourcePool::clear()
+{
+	m_free.clear();
+	m_byId.clear();
+	m_sources.clear();
+	m_pollCursor = 0;
+	m_stats.capacity = 0;
+	m_stats.inUse = 0;
+}
+
+AudioSource* AudioSourcePool::find(ALuint id) const
+{
+	auto it = m_byId.find(id);
+	return it != m_byId.end() ? it->second : nullptr;
+}
+
+void AudioSourcePool::pollFinished(size_t count)
+{
+	if (m_sources.empty()) return;
+	if (count > m_sources.size()) count = m_sources.size();
+	for (size_t i = 0; i < count; ++i) {
+		if (m_pollCursor >= m_sources.size()) m_pollCursor = 0;
+		AudioSource* src = m_sources[m_pollCursor++].get();
+		if (!src->hasStopped()) src->pollFinished(); //free sources have no buffer and don't need asking
+	}
+}
@@ -0,0 +1,171 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "AudioStream.h"
+#include <iostream>
+#include <chrono>
+#include <system_error>
+
+#include <ogg.h>
+#include <vorbisfile.h>
+
+AudioStream::AudioStream() : m_vf(std::make_unique<OggVorbis_File>())
+{
+	alGetError();
+	alGenBuffers(NUM_BUFFERS, m_buffers);
+	if (alGetError() != AL_NO_ERROR) {
+		std::cerr << "Could not generate stream buffers!\n";
+	}
+}
+
+AudioStream::~AudioStream()
+{
+	stop();
+	alDeleteBuffers(NUM_BUFFERS, m_buffers);
+}
+
+bool AudioStream::play(const std::string& fname)
+{
+	stop();
+
+	m_stopRequested = false;
+	m_running = true;
+	try {
+		m_thread = std::thread(&AudioStream::m_run, this, fname);
+	}
+	catch (const std::system_error& e) {
+		std::cerr << "Could not start streaming thread: " << e.what() << std::endl;
+		m_running = false;
+		return false;
+	}
+	return true;
+}
+
+void AudioStream::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_wake.notify_all();
+	if (m_thread.joinable()) m_thread.join();
+	m_running = false;
+}
+
+bool AudioStream::m_open(const std::string& fname)
+{
+	m_fp = fopen(fname.c_str(), "rb");
+	if (!m_fp) {
+		std::cerr << "Could not open file: " << fname << std::endl;
+		return false;
+	}
+	if (ov_open_callbacks(m_fp, m_vf.get(), NULL, 0, OV_CALLBACKS_NOCLOSE) < 0) {
+		std::cerr << "Stream is not a valid OggVorbis stream: " << fname << std::endl;
+		fclose(m_fp);
+		m_fp = nullptr;
+		return false;
+	}
+	vorbis_info* vi = ov_info(m_vf.get(), -1);
+	m_format = vi->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+	m_rate = (ALsizei)vi->rate;
+	return true;
+}
+
+void AudioStream::m_close()
+{
+	if (!m_fp) return;
+	ov_clear(m_vf.get());
+	fclose(m_fp);
+	m_fp = nullptr;
+}
+
+bool AudioStream::m_fill(ALuint buffer)
+{
+	size_t filled = 0;
+	int sel = 0;
+	bool rewound = false;
+	while (filled < BUFFER_SIZE) {
+		long size = ov_read(m_vf.get(), m_pcm + filled, (int)(BUFFER_SIZE - filled), 0, 2, 1, &sel);
+		if (size == OV_HOLE) continue; //a gap in the data, the decoder picks back up on the next read
+		if (size < 0) {
+			std::cerr << "This ogg file is faulty.\n";
+			break;
+		}
+		if (size == 0) { //end of the file - go back to the start if we're looping, otherwise we're done
+			if (!m_loop || rewound) break;
+			if (ov_pcm_seek(m_vf.get(), 0) != 0) break;
+			rewound = true;
+			continue;
+		}
+		rewound = false;
+		filled += (size_t)size;
+	}
+	if (filled == 0) return false;
+
+	alBufferData(buffer, m_format, m_pcm, (ALsizei)filled, m_rate);
+	return true;
+}
+
+void AudioStream::m_run(std::string fname)
+{
+	if (!m_open(fname)) {
+		m_running = false;
+		return;
+	}
+	alGetError();
+	int queued = 0;
+	for (int i = 0; i < NUM_BUFFERS; ++i) {
+		if (!m_fill(m_buffers[i])) break;
+		alSourceQueueBuffers(m_source.source, 1, &m_buffers[i]);
+		++queued;
+	}
+	if (queued > 0) alSourcePlay(m_source.source);
+
+	while (!m_stopRequested && queued > 0) {
+		ALint processed = 0;
+		alGetSourcei(m_source.source, AL_BUFFERS_PROCESSED, &processed);
+		while (processed-- > 0) {
+			ALuint buffer = 0;
+			alSourceUnqueueBuffers(m_source.source, 1, &buffer);
+			--queued;
+			if (m_fill(buffer)) {
+				alSourceQueueBuffers(m_source.source, 1, &buffer);
+				++queued;
+			}
+		}
+		ALint state = 0;
+		alGetSourcei(m_source.source, AL_SOURCE_STATE, &state);
+		if (state != AL_PLAYING && state != AL_PAUSED) {
+			//either the decoder fell behind and the source ran dry, or the file is done and the last buffer just finished
+			ALint remaining = 0;
+			alGetSourcei(m_source.source, AL_BUFFERS_QUEUED, &remaining);
+			if (remaining > 0 && queued > 0) alSourcePlay(m_source.source);
+			else break;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wake.wait_for(lock, std::chrono::milliseconds(20), [this] { return m_stopRequested.load(); });
+	}
+
+	alSourceStop(m_source.source);
+	alSourcei(m_source.source, AL_BUFFER, 0); //detaching the buffer unqueues everything
+	m_close();
+	m_running = false;
+}
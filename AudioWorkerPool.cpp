@@ -0,0 +1,69 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "AudioWorkerPool.h"
+
+AudioWorkerPool::AudioWorkerPool(unsigned int threads)
+{
+	if (threads == 0) {
+		unsigned int cores = std::thread::hardware_concurrency();
+		threads = cores > 1 ? cores - 1 : 1;
+	}
+	m_threads.reserve(threads);
+	for (unsigned int i = 0; i < threads; ++i) {
+		m_threads.emplace_back(&AudioWorkerPool::m_work, this);
+	}
+}
+
+AudioWorkerPool::~AudioWorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+}
+
+void AudioWorkerPool::submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_wake.notify_one();
+}
+
+void AudioWorkerPool::m_work()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+			if (m_jobs.empty()) return; //only empty here if we're stopping
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+		job();
+	}
+}
@@ -0,0 +1,226 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "PcmCache.h"
+#include "AudioHash.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+
+namespace fs = std::filesystem;
+
+static const char CACHE_MAGIC[4] = { 'B', 'P', 'C', 'M' };
+static const char CACHE_EXTENSION[] = ".pcm";
+
+bool PcmCache::setDirectory(const std::string& dir, uint64_t maxBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_dir = "";
+	m_maxBytes = maxBytes;
+	m_stats.bytes = 0;
+	if (dir.empty()) return true;
+
+	std::error_code err;
+	fs::create_directories(dir, err);
+	if (!fs::is_directory(dir, err)) {
+		std::cerr << "Could not create PCM cache directory: " << dir << std::endl;
+		return false;
+	}
+	for (const auto& entry : fs::directory_iterator(dir, err)) {
+		if (entry.path().extension() == CACHE_EXTENSION) m_stats.bytes += entry.file_size(err);
+	}
+	m_dir = dir;
+	m_evict();
+	return true;
+}
+
+std::string PcmCache::m_entryPath(const std::string& dir, const std::string& sourcePath, uint64_t variant)
+{
+	std::error_code err;
+	std::string key = fs::absolute(sourcePath, err).generic_string();
+	if (err) key = sourcePath;
+	char name[48];
+	if (variant == 0) snprintf(name, sizeof(name), "%016llx", (unsigned long long)fnv1a64(key.data(), key.size()));
+	else snprintf(name, sizeof(name), "%016llx-%llx", (unsigned long long)fnv1a64(key.data(), key.size()), (unsigned long long)variant);
+	return (fs::path(dir) / (std::string(name) + CACHE_EXTENSION)).string();
+}
+
+bool PcmCache::m_hashFile(const std::string& path, uint64_t& hash)
+{
+	MappedFile file;
+	if (!file.open(path)) return false;
+	hash = fnv1a64(file.getData(), file.getSize());
+	return true;
+}
+
+bool PcmCache::lookup(const std::string& sourcePath, CachedPcm& out, uint64_t variant)
+{
+	std::string dir;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		dir = m_dir; //setDirectory can change it from another thread
+	}
+	if (dir.empty()) return false;
+
+	std::error_code err;
+	uint64_t sourceTime = (uint64_t)fs::last_write_time(sourcePath, err).time_since_epoch().count();
+	uint64_t sourceSize = err ? 0 : (uint64_t)fs::file_size(sourcePath, err);
+	std::string entryPath = m_entryPath(dir, sourcePath, variant);
+	if (err || !fs::exists(entryPath, err)) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_stats.misses;
+		return false;
+	}
+
+	auto file = std::make_unique<MappedFile>();
+	Header header;
+	bool fresh = file->open(entryPath) && file->getSize() >= sizeof(Header);
+	if (fresh) {
+		memcpy(&header, file->getData(), sizeof(Header));
+		fresh = memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header.version == VERSION
+			&& header.sourceSize == sourceSize && sizeof(Header) + header.dataSize <= file->getSize();
+	}
+	if (fresh && header.sourceTime != sourceTime) {
+		//the file got touched, but it's only stale if the contents actually changed
+		uint64_t hash = 0;
+		fresh = m_hashFile(sourcePath, hash) && hash == header.contentHash;
+		if (fresh) {
+			//remember the new time so the next lookup doesn't have to hash it again. The entry can't be written while it's mapped on
+			//Windows, so it gets closed and mapped again around the write. If that fails, the next lookup just hashes it again.
+			file->close();
+			{
+				std::fstream entry(entryPath, std::ios::binary | std::ios::in | std::ios::out);
+				header.sourceTime = sourceTime;
+				if (entry.seekp(offsetof(Header, sourceTime))) entry.write((const char*)&header.sourceTime, sizeof(header.sourceTime));
+			}
+			fresh = file->open(entryPath) && file->getSize() >= sizeof(Header) + header.dataSize;
+		}
+	}
+	if (!fresh) {
+		file->close();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint64_t size = fs::file_size(entryPath, err);
+		if (fs::remove(entryPath, err) && m_stats.bytes >= size) m_stats.bytes -= size;
+		++m_stats.stale;
+		++m_stats.misses;
+		return false;
+	}
+
+	fs::last_write_time(entryPath, fs::file_time_type::clock::now(), err); //keeps the LRU order up to date
+	out.data = file->getData() + sizeof(Header);
+	out.size = (size_t)header.dataSize;
+	out.format = header.format;
+	out.rate = header.rate;
+	out.channels = header.channels;
+	out.file = std::move(file);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_stats.hits;
+	return true;
+}
+
+void PcmCache::store(const std::string& sourcePath, int32_t format, int32_t rate, int32_t channels, const char* pcm, size_t size, uint64_t variant)
+{
+	std::string dir;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_dir.empty()) return;
+		if (m_maxBytes > 0 && sizeof(Header) + size > m_maxBytes) return; //would never fit anyway
+		dir = m_dir;
+	}
+
+	Header header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = VERSION;
+	std::error_code err;
+	header.sourceTime = (uint64_t)fs::last_write_time(sourcePath, err).time_since_epoch().count();
+	header.sourceSize = err ? 0 : (uint64_t)fs::file_size(sourcePath, err);
+	if (err || !m_hashFile(sourcePath, header.contentHash)) return;
+	header.format = format;
+	header.rate = rate;
+	header.channels = channels;
+	header.reserved = 0;
+	header.dataSize = size;
+
+	//write to a temporary file first so a half-written entry is never picked up by a lookup
+	std::string entryPath = m_entryPath(dir, sourcePath, variant);
+	std::string tempPath = entryPath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out) return;
+		out.write((const char*)&header, sizeof(Header));
+		out.write(pcm, size);
+		if (!out) {
+			out.close();
+			fs::remove(tempPath, err);
+			return;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_dir != dir) { //the cache got moved or turned off while this was being written
+		fs::remove(tempPath, err);
+		return;
+	}
+	uint64_t oldSize = fs::exists(entryPath, err) ? fs::file_size(entryPath, err) : 0;
+	fs::rename(tempPath, entryPath, err);
+	if (err) {
+		fs::remove(tempPath, err);
+		return;
+	}
+	m_stats.bytes = m_stats.bytes - std::min(m_stats.bytes, oldSize) + sizeof(Header) + size;
+	m_evict();
+}
+
+void PcmCache::m_evict()
+{
+	if (m_maxBytes == 0 || m_stats.bytes <= m_maxBytes) return;
+
+	struct Entry {
+		fs::path path;
+		fs::file_time_type used;
+		uint64_t size;
+	};
+	std::vector<Entry> entries;
+	std::error_code err;
+	for (const auto& entry : fs::directory_iterator(m_dir, err)) {
+		if (entry.path().extension() != CACHE_EXTENSION) continue;
+		entries.push_back({ entry.path(), entry.last_write_time(err), entry.file_size(err) });
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+	for (const auto& entry : entries) {
+		if (m_stats.bytes <= m_maxBytes) break;
+		if (!fs::remove(entry.path, err)) continue; //still mapped by someone on some platforms, try the next one
+		m_stats.bytes -= std::min(m_stats.bytes, entry.size);
+		++m_stats.evictions;
+	}
+}
+
+PcmCache::Stats PcmCache::getStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
@@ -0,0 +1,136 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "PolyphaseResampler.h"
+#include <cmath>
+#include <numeric>
+
+namespace {
+	//Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+	double besselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 32; ++k) {
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+			if (term < sum * 1e-12) break;
+		}
+		return sum;
+	}
+}
+
+bool PolyphaseResampler::init(int channels, int inRate, int outRate, int halfTaps)
+{
+	if (channels <= 0 || inRate <= 0 || outRate <= 0 || inRate == outRate || halfTaps <= 0) return false;
+	int divisor = std::gcd(inRate, outRate);
+	if (outRate / divisor > MAX_PHASES) return false;
+
+	m_channels = channels;
+	m_halfTaps = halfTaps;
+	m_up = (uint32_t)(outRate / divisor);
+	m_down = (uint32_t)(inRate / divisor);
+
+	//the cutoff sits a little under whichever Nyquist frequency is lower, so downsampling doesn't alias
+	const double PI = 3.14159265358979323846;
+	const double beta = 8.0;
+	double cutoff = 0.95 * std::min(1.0, (double)m_up / (double)m_down);
+	int taps = 2 * halfTaps;
+	m_coeffs.assign((size_t)m_up * taps, 0.f);
+	double window = besselI0(beta);
+	for (uint32_t phase = 0; phase < m_up; ++phase) {
+		float* c = &m_coeffs[(size_t)phase * taps];
+		double sum = 0.0;
+		for (int j = 0; j < taps; ++j) {
+			double x = (double)(j - halfTaps + 1) - (double)phase / (double)m_up; //distance from the output sample, in input samples
+			double sinc = x == 0.0 ? 1.0 : std::sin(PI * cutoff * x) / (PI * cutoff * x);
+			double r = x / (double)halfTaps;
+			double w = r * r < 1.0 ? besselI0(beta * std::sqrt(1.0 - r * r)) / window : 0.0;
+			c[j] = (float)(cutoff * sinc * w);
+			sum += c[j];
+		}
+		for (int j = 0; j < taps; ++j) c[j] = (float)(c[j] / sum); //every phase passes DC at exactly unity gain
+	}
+
+	//the filter looks back halfTaps - 1 samples from the first output, which would be before the start of the audio
+	m_history.assign(channels, std::vector<float>(halfTaps - 1, 0.f));
+	m_base = -(int64_t)(halfTaps - 1);
+	m_nextOut = 0;
+	m_out.assign(channels, std::vector<float>());
+	m_outPlanes.assign(channels, nullptr);
+	return true;
+}
+
+size_t PolyphaseResampler::process(const float* const* planes, size_t frames)
+{
+	for (int c = 0; c < m_channels; ++c) m_history[c].insert(m_history[c].end(), planes[c], planes[c] + frames);
+	return m_run();
+}
+
+size_t PolyphaseResampler::flush()
+{
+	for (int c = 0; c < m_channels; ++c) m_history[c].insert(m_history[c].end(), (size_t)m_halfTaps + 1, 0.f);
+	return m_run();
+}
+
+size_t PolyphaseResampler::m_run()
+{
+	const int taps = 2 * m_halfTaps;
+	int64_t available = m_base + (int64_t)m_history[0].size(); //one past the last input frame we have
+
+	//work out how many outputs have every input they need, so the output can be sized once
+	size_t count = 0;
+	for (uint64_t n = m_nextOut;; ++n) {
+		int64_t i = (int64_t)(n * m_down / m_up);
+		if (i + m_halfTaps >= available) break;
+		++count;
+	}
+	for (int c = 0; c < m_channels; ++c) {
+		m_out[c].resize(count);
+		m_outPlanes[c] = m_out[c].data();
+	}
+
+	for (size_t o = 0; o < count; ++o, ++m_nextOut) {
+		uint64_t t = m_nextOut * m_down;
+		int64_t i = (int64_t)(t / m_up);
+		const float* coeffs = &m_coeffs[(size_t)(t % m_up) * taps];
+		size_t first = (size_t)(i - m_halfTaps + 1 - m_base);
+		for (int c = 0; c < m_channels; ++c) {
+			const float* x = m_history[c].data() + first;
+			float a0 = 0.f, a1 = 0.f, a2 = 0.f, a3 = 0.f; //separate sums so the compiler can keep them in one vector
+			for (int j = 0; j + 4 <= taps; j += 4) {
+				a0 += x[j] * coeffs[j];
+				a1 += x[j + 1] * coeffs[j + 1];
+				a2 += x[j + 2] * coeffs[j + 2];
+				a3 += x[j + 3] * coeffs[j + 3];
+			}
+			for (int j = taps & ~3; j < taps; ++j) a0 += x[j] * coeffs[j];
+			m_out[c][o] = (a0 + a1) + (a2 + a3);
+		}
+	}
+
+	//drop whatever input the next output won't look at anymore
+	int64_t keepFrom = (int64_t)(m_nextOut * m_down / m_up) - m_halfTaps + 1;
+	if (keepFrom > m_base) {
+		size_t drop = (size_t)std::min<int64_t>(keepFrom - m_base, (int64_t)m_history[0].size());
+		for (int c = 0; c < m_channels; ++c) m_history[c].erase(m_history[c].begin(), m_history[c].begin() + drop);
+		m_base += (int64_t)drop;
+	}
+	return count;
+}
@@ -0,0 +1,159 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#include "SoundBank.h"
+#include "AudioHash.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+static const char BANK_MAGIC[4] = { 'B', 'S', 'B', 'K' };
+
+uint64_t SoundBank::hashName(const char* str, size_t len)
+{
+	return fnv1a64(str, len);
+}
+
+bool SoundBank::open(const std::string& path)
+{
+	close();
+	if (!m_file.open(path)) return false;
+
+	Header header;
+	if (m_file.getSize() < sizeof(Header)) {
+		std::cerr << "Sound bank is too small to be a sound bank: " << path << std::endl;
+		close();
+		return false;
+	}
+	memcpy(&header, m_file.getData(), sizeof(Header));
+	if (memcmp(header.magic, BANK_MAGIC, sizeof(BANK_MAGIC)) != 0 || header.version != VERSION) {
+		std::cerr << "Not a valid sound bank: " << path << std::endl;
+		close();
+		return false;
+	}
+	if (sizeof(Header) + (uint64_t)header.count * sizeof(Entry) > m_file.getSize()) {
+		std::cerr << "Sound bank index is truncated: " << path << std::endl;
+		close();
+		return false;
+	}
+	m_count = header.count;
+	for (size_t i = 0; i < m_count; ++i) {
+		Entry entry = m_entry(i);
+		if ((uint64_t)entry.nameOffset + entry.nameLength > m_file.getSize() || entry.dataOffset + entry.dataSize > m_file.getSize()) {
+			std::cerr << "Sound bank entry " << i << " points outside the file: " << path << std::endl;
+			close();
+			return false;
+		}
+	}
+	m_path = path;
+	return true;
+}
+
+void SoundBank::close()
+{
+	m_file.close();
+	m_path = "";
+	m_count = 0;
+}
+
+SoundBank::Entry SoundBank::m_entry(size_t i) const
+{
+	Entry entry;
+	memcpy(&entry, m_file.getData() + sizeof(Header) + i * sizeof(Entry), sizeof(Entry));
+	return entry;
+}
+
+bool SoundBank::find(const std::string& name, const char*& data, size_t& size) const
+{
+	if (m_count == 0) return false;
+	uint64_t hash = hashName(name.data(), name.size());
+
+	//binary search for the first entry with this hash, then walk forward in case of collisions
+	size_t low = 0, high = m_count;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (m_entry(mid).nameHash < hash) low = mid + 1;
+		else high = mid;
+	}
+	for (size_t i = low; i < m_count; ++i) {
+		Entry entry = m_entry(i);
+		if (entry.nameHash != hash) break;
+		if (entry.nameLength != name.size()) continue;
+		if (memcmp(m_file.getData() + entry.nameOffset, name.data(), name.size()) != 0) continue;
+		data = m_file.getData() + entry.dataOffset;
+		size = (size_t)entry.dataSize;
+		return true;
+	}
+	return false;
+}
+
+bool SoundBank::pack(const std::string& outPath, const std::vector<std::string>& names, const std::vector<std::string>& paths)
+{
+	if (names.size() != paths.size()) return false;
+
+	std::vector<size_t> order(names.size());
+	for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::vector<uint64_t> hashes(names.size());
+	for (size_t i = 0; i < names.size(); ++i) hashes[i] = hashName(names[i].data(), names[i].size());
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		if (hashes[a] != hashes[b]) return hashes[a] < hashes[b];
+		return names[a] < names[b];
+	});
+
+	std::vector<Entry> entries(names.size());
+	uint64_t offset = sizeof(Header) + names.size() * sizeof(Entry);
+	for (size_t i = 0; i < order.size(); ++i) {
+		size_t idx = order[i];
+		entries[i].nameHash = hashes[idx];
+		entries[i].nameOffset = (uint32_t)offset;
+		entries[i].nameLength = (uint32_t)names[idx].size();
+		offset += names[idx].size();
+	}
+	std::vector<std::vector<char>> files(names.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		size_t idx = order[i];
+		std::ifstream in(paths[idx], std::ios::binary);
+		if (!in) {
+			std::cerr << "Could not open file: " << paths[idx] << std::endl;
+			return false;
+		}
+		files[i].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		entries[i].dataOffset = offset;
+		entries[i].dataSize = files[i].size();
+		offset += files[i].size();
+	}
+
+	std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cerr << "Could not write sound bank: " << outPath << std::endl;
+		return false;
+	}
+	Header header;
+	memcpy(header.magic, BANK_MAGIC, sizeof(BANK_MAGIC));
+	header.version = VERSION;
+	header.count = (uint32_t)names.size();
+	header.reserved = 0;
+	out.write((const char*)&header, sizeof(Header));
+	out.write((const char*)entries.data(), entries.size() * sizeof(Entry));
+	for (size_t idx : order) out.write(names[idx].data(), names[idx].size());
+	for (const auto& file : files) out.write(file.data(), file.size());
+	return (bool)out;
+}
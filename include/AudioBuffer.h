@@ -22,26 +22,242 @@
 #ifndef AUDIOBUFFER_H
 #define AUDIOBUFFER_H
 #include <unordered_map>
+#include <unordered_set>
 #include <al.h>
 #include <string>
+#include "MappedFile.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <cstdint>
+
+class AudioWorkerPool;
+class AudioExtensions;
+class SoundBank;
+class PcmCache;
+struct OggVorbis_File;
 /*
 * Audio buffers should absolutely never be seen outside of the base AudioDriver class. Their primary purpose is to both load and store
 * .ogg files for use as game sounds or for music. They keep this data stored in an internal map so it can be re-called on demand.
 * 
 * There are a few audio buffers in use, one for game sounds and one for menu sounds. Sounds are pretty hefty, so the game sounds buffer gets wiped
 * at the end of every scenario. The menu sound buffer should not be wiped.
+*
+* Audio can also be loaded asynchronously: the file gets decoded on a worker pool and the finished PCM waits in a queue until processLoads
+* is called from the thread that owns the OpenAL context, which is where the actual buffer gets created.
+*
+* Sound banks can be mounted on a buffer. Anything that's in a mounted bank gets decoded straight out of the bank instead of opening the
+* loose file. Loose files can also go through a PCM cache, which skips decoding entirely for files that were decoded on a previous run.
+*
+* Where OpenAL allows it, decoded audio isn't copied into OpenAL at all. With AL_EXT_STATIC_BUFFER the buffer plays straight out of the
+* decoded PCM, which then belongs to the buffer's entry and gets freed along with it. With AL_SOFT_map_buffer, synchronous loads decode
+* straight into OpenAL's own storage. Without either, the PCM gets copied in with alBufferData like always.
+*
+* Loaded audio can be kept under a memory budget. Sources playing a buffer hold a reference to it through acquire/release, and when the
+* budget is exceeded the least recently used buffers that nothing is playing (and that aren't pinned) get deleted to make room.
 */
 class AudioBuffer
 {
 public:
+	//How long a background load took, split into the decode on the worker and the upload to OpenAL.
+	struct LoadTiming {
+		std::string fname;
+		float decodeMs = 0.f;
+		float uploadMs = 0.f;
+		size_t bytes = 0; //size of the decoded PCM
+		size_t savedBytes = 0; //how much smaller the PCM came out for being downmixed to mono
+		float resampleMs = 0.f; //how much of the decode was spent resampling
+		int64_t resampleBytes = 0; //how much bigger (or smaller, if negative) the PCM came out for being resampled
+		bool loaded = false;
+		//Decode throughput in MB of PCM per second.
+		float decodeMBps() const { return decodeMs > 0.f ? (float)bytes / (decodeMs * 1000.f) : 0.f; }
+	};
+	//What sample format decoded audio gets handed to OpenAL in.
+	enum SamplePrecision {
+		PRECISION_INT16,
+		PRECISION_FLOAT32 //needs AL_EXT_FLOAT32. Twice the memory, but skips the conversion and keeps the decoder's full precision.
+	};
+	//Memory usage and cache counters for the buffer.
+	struct CacheStats {
+		size_t residentBytes = 0;
+		size_t budget = 0;
+		size_t buffers = 0;
+		uint64_t evictions = 0;
+		uint64_t hits = 0; //a buffer was already resident when something wanted to play it
+		uint64_t misses = 0; //a buffer had to be loaded
+		size_t staticBytes = 0; //resident bytes OpenAL is playing straight out of our memory, rather than its own copy
+		uint64_t downmixSavedBytes = 0; //total PCM saved by downmixing loads to mono
+		uint64_t resampled = 0; //number of loads that got resampled
+		int64_t resampleBytes = 0; //total PCM added (or saved, if negative) by resampling loads
+		float hitRate() const { return hits + misses > 0 ? (float)hits / (float)(hits + misses) : 0.f; }
+	};
+
+	//Deletes all the audio, so OpenAL is done with any static PCM before it gets freed. The OpenAL context has to still be around.
+	~AudioBuffer();
+
 	//Loads audio from a filename into a buffer.
 	ALuint loadAudio(std::string fname);
+	//Starts loading audio from a filename on the worker pool. The future becomes ready once processLoads has uploaded the audio, and holds
+	//0 if the load failed. If the audio is already loaded (or there's no worker pool) the future is ready straight away.
+	std::shared_future<ALuint> loadAudioAsync(std::string fname);
+	//Uploads any audio that has finished decoding on the worker pool. Has to be called from the thread that owns the OpenAL context.
+	//Returns the number of loads that got finished. If timings is given, the timing for each finished load gets appended to it.
+	size_t processLoads(std::vector<LoadTiming>* timings = nullptr);
+	//Returns whether or not the given file is still being loaded in the background.
+	bool isLoading(const std::string& fname) const { return m_pending.find(fname) != m_pending.end(); }
+	//Sets the worker pool used for asynchronous loads. Without one, loadAudioAsync just loads synchronously.
+	void setWorkerPool(AudioWorkerPool* pool) { m_workers = pool; }
+	//Sets the sample format that new loads get decoded to. Audio that's already loaded keeps whatever format it was decoded in, and the PCM
+	//cache keeps decodes in each format apart. Only ask for PRECISION_FLOAT32 if AL_EXT_FLOAT32 is there. Default: PRECISION_INT16
+	void setPrecision(SamplePrecision precision) { m_options.precision = precision; }
+	//Returns the sample format new loads get decoded to.
+	SamplePrecision getPrecision() const { return m_options.precision; }
+	//Sets whether new loads with more than one channel get mixed down to mono. OpenAL only spatializes mono buffers, so anything played
+	//positionally should be mono, and it halves the memory of stereo files. Like setPrecision, this only affects loads from here on, and
+	//the PCM cache keeps mono and full channel decodes of a file apart. Default: False
+	void setDownmix(bool downmix) { m_options.downmix = downmix; }
+	//Returns whether new loads get mixed down to mono.
+	bool getDownmix() const { return m_options.downmix; }
+	//Sets the sample rate new loads get resampled to, so OpenAL doesn't have to convert them every time they play. 0 leaves loads at their
+	//own rate. Rates that don't reduce to a reasonable ratio with the file's are left alone too. Like setPrecision, this only affects loads
+	//from here on, and the PCM cache keeps decodes at different rates apart. Default: 0
+	void setResampleRate(int rate) { m_options.resampleRate = rate > 0 ? rate : 0; }
+	//Returns the sample rate new loads get resampled to, or 0 if they aren't.
+	int getResampleRate() const { return m_options.resampleRate; }
+	//Sets the OpenAL extensions to upload through. Without them, every upload is a copy. Has to be loaded before any audio is.
+	void setExtensions(const AudioExtensions* ext) { m_ext = ext; }
+	//Sets the on-disk cache of decoded PCM used for loose files. Null turns it off.
+	void setPcmCache(PcmCache* cache) { m_cache = cache; }
+	//Mounts a sound bank. A sound in the bank gets used whenever prefix + its name in the bank is loaded.
+	bool mountBank(const std::string& path, const std::string& prefix = "");
+	//Unmounts every sound bank. Audio that was already loaded from them stays loaded.
+	void unmountBanks() { m_banks.clear(); }
 	//Removes the audio from a buffer.
 	bool removeAudio(const ALuint& buf);
-	//Removes all audio from the buffer.
+	//Removes all audio from the buffer. Loads that are still in flight will finish and get added afterwards.
 	void removeAllAudio();
+	//Returns the length of a loaded buffer in seconds, or 0 if it isn't one of ours.
+	float getLength(const ALuint& buf) const;
+	//Returns whether or not the buffer is still loaded - it might have been evicted.
+	bool isResident(const ALuint& buf) const { return m_entries.find(buf) != m_entries.end(); }
+
+	//Takes a reference on a buffer for something that's about to play it. Referenced buffers never get evicted.
+	//countHit should be false if the buffer was only just loaded for this play, so it isn't counted as a cache hit.
+	void acquire(const ALuint& buf, bool countHit = true);
+	//Drops a reference on a buffer once the sound playing it is done.
+	void release(const ALuint& buf);
+	//Pins a file so that it never gets evicted, or unpins it. This also applies if the file gets loaded later.
+	void pin(const std::string& fname, bool pinned = true);
+	//Sets the memory budget for loaded audio in bytes, evicting idle buffers straight away if it's exceeded. 0 means no limit.
+	void setBudget(size_t bytes);
+	//Sets a function that gets called with any buffer that gets evicted, so anything caching buffer IDs can forget about it.
+	void setEvictionCallback(std::function<void(ALuint)> callback) { m_onEvict = callback; }
+	//Returns the memory usage and cache counters.
+	CacheStats getCacheStats() const;
 private:
+	//Bookkeeping for a loaded buffer.
+	struct _BufferEntry {
+		std::string fname;
+		size_t bytes = 0;
+		float length = 0.f;
+		uint32_t refs = 0;
+		uint64_t lastUse = 0;
+		std::unique_ptr<char[]> staticPcm; //the PCM OpenAL is reading from, if the buffer was made with alBufferDataStatic
+	};
+	//PCM data decoded from a file, waiting to get handed to OpenAL.
+	struct _DecodedAudio {
+		std::string fname;
+		ALenum format = 0;
+		ALsizei rate = 0;
+		int channels = 0;
+		std::unique_ptr<char[]> pcm;
+		std::unique_ptr<MappedFile> mapped; //set instead of pcm when the audio came out of the PCM cache
+		const char* data = nullptr; //whichever of the two actually holds the audio; null if the load failed
+		size_t size = 0;
+		float decodeMs = 0.f;
+		ALuint mappedBuffer = 0; //set instead of pcm when the audio got decoded straight into a mapped OpenAL buffer
+		size_t mappedSize = 0;
+		size_t savedBytes = 0;
+		float resampleMs = 0.f;
+		int64_t resampleBytes = 0;
+	};
+	//How loads should come out of the decoder.
+	struct _DecodeOptions {
+		SamplePrecision precision = PRECISION_INT16;
+		bool downmix = false;
+		int resampleRate = 0;
+	};
+	//Hands out the memory for a decode to write into, given the audio with its format, rate and channels filled in and the size in bytes.
+	//Returning nullptr (or not having one at all) decodes onto the heap.
+	typedef std::function<char*(_DecodedAudio& audio, size_t bytes)> _PcmAllocator;
+	//Decodes finished by the worker pool. This is shared with the jobs so it stays alive even if the buffer goes away mid-load.
+	struct _LoadQueue {
+		std::mutex mutex;
+		std::vector<_DecodedAudio> done;
+	};
+	struct _PendingLoad {
+		std::promise<ALuint> promise;
+		std::shared_future<ALuint> future;
+	};
+	struct _MountedBank {
+		std::shared_ptr<SoundBank> bank;
+		std::string prefix;
+	};
+	//Reads and decodes an .ogg file. Doesn't touch OpenAL, so this is safe to run from any thread.
+	static bool m_decode(const std::string& fname, const _DecodeOptions& options, const _PcmAllocator& alloc, _DecodedAudio& out);
+	//Decodes an .ogg file that's already sitting in memory. Also safe to run from any thread.
+	static bool m_decodeMemory(const std::string& fname, const char* data, size_t size, const _DecodeOptions& options, const _PcmAllocator& alloc,
+		_DecodedAudio& out);
+	//Gets the PCM for a file from wherever it lives - a mounted bank, the PCM cache, or the loose file. Safe to run from any thread.
+	static bool m_loadSource(const std::string& fname, const char* bankData, size_t bankSize, PcmCache* cache, const _DecodeOptions& options,
+		const _PcmAllocator& alloc, _DecodedAudio& out);
+	//Decodes everything out of an opened Vorbis stream, straight into the buffer that gets handed to OpenAL.
+	static bool m_decodeVorbis(OggVorbis_File& vf, const _DecodeOptions& options, const _PcmAllocator& alloc, _DecodedAudio& out);
+	//Returns which PCM cache entry holds a file decoded with the given options.
+	static uint64_t m_cacheVariant(const _DecodeOptions& options);
+	//Returns whether audio in the given format and channel count is what a decode with the given options would have made.
+	static bool m_matchesOptions(ALenum format, int channels, const _DecodeOptions& options);
+	//Returns the size of one sample in the given format.
+	static int m_bytesPerSample(ALenum format);
+	//Looks for the file in the mounted banks. The bank is handed back too, so a background load can keep it mapped until it's done.
+	bool m_findInBanks(const std::string& fname, std::shared_ptr<SoundBank>& bank, const char*& data, size_t& size) const;
+	//Creates an OpenAL buffer from decoded audio and registers it. Returns 0 on failure.
+	ALuint m_upload(_DecodedAudio& audio);
+	//Makes an allocator that decodes straight into a mapped OpenAL buffer, if that's the best way to upload on this implementation.
+	//Only usable from the thread that owns the context.
+	_PcmAllocator m_mappedAllocator();
+	//Gets rid of a mapped buffer from a decode that didn't work out.
+	void m_discardMapped(_DecodedAudio& audio);
+	//Evicts idle buffers, least recently used first, until the buffer is back under budget. Buffers in keep are left alone.
+	void m_enforceBudget(const std::vector<ALuint>& keep);
+	//Deletes a buffer and forgets about it.
+	void m_delete(ALuint buf);
+
 	std::unordered_map<std::string, ALuint> buffers;
+	std::unordered_map<ALuint, _BufferEntry> m_entries;
+	std::unordered_set<std::string> m_pinned;
+	std::function<void(ALuint)> m_onEvict;
+	size_t m_residentBytes = 0;
+	size_t m_budget = 0;
+	uint64_t m_useCounter = 0;
+	uint64_t m_evictions = 0;
+	uint64_t m_hits = 0;
+	uint64_t m_misses = 0;
+
+	std::unordered_map<std::string, _PendingLoad> m_pending;
+	std::vector<_MountedBank> m_banks;
+	std::shared_ptr<_LoadQueue> m_loadQueue = std::make_shared<_LoadQueue>();
+	AudioWorkerPool* m_workers = nullptr;
+	PcmCache* m_cache = nullptr;
+	_DecodeOptions m_options;
+	const AudioExtensions* m_ext = nullptr;
+	size_t m_staticBytes = 0;
+	uint64_t m_downmixSavedBytes = 0;
+	uint64_t m_resampled = 0;
+	int64_t m_resampleBytes = 0;
+	std::vector<std::unique_ptr<char[]>> m_orphanedPcm; //static PCM whose buffer OpenAL wouldn't delete, so it might still be reading it
 };
 
 #endif 
\ No newline at end of file
@@ -23,26 +23,107 @@
 #ifndef AUDIODRIVER_H
 #define AUDIODRIVER_H
 #include "AudioBuffer.h"
+#include "AudioExtensions.h"
 #include "AudioSource.h"
+#include "AudioSourcePool.h"
+#include "AudioStream.h"
+#include "AudioWorkerPool.h"
+#include "AudioHash.h"
+#include "AudioMath.h"
+#include "AudioListener.h"
+#include "VoiceTable.h"
+#include "EntityTraits.h"
+#include "SpscRing.h"
+#include "PcmCache.h"
 #include <alc.h>
 #include <random>
 #include <functional>
 #include <memory>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
 #include <stdio.h>
+#include <iostream>
+//A sound name that's been resolved ahead of time with registerSound. Playing a sound by its SoundId skips all the string work on
+//the play path - it's just an index into the driver's sound table. SoundIds stay valid for the lifetime of the driver.
+struct SoundId {
+	static constexpr uint32_t INVALID = 0xFFFFFFFF;
+	uint32_t index = INVALID;
+	bool isValid() const { return index != INVALID; }
+	bool operator==(const SoundId& other) const { return index == other.index; }
+	bool operator!=(const SoundId& other) const { return index != other.index; }
+};
+
 /*
 * The audio driver class does what you think it does and handles the audio for the game itself, including the loading of files, playing of audio,
 * and management of various sound sources within a scene. It keeps track of anything that is currently making noise in the game, be that a menu sound
 * effect, the music, or in-game effects.
+*
+* T is whatever the game uses as an entity, usually a handle or a pointer. It gets stored by value with every sound, so it has to be default
+* constructible and copyable; positional sounds that aren't attached to anything hold a default constructed one.
 */
-template<class T>
+template<class T, class EntityTraits = FunctionEntityTraits<T>>
 class AudioDriver
 {
+	static_assert(std::is_default_constructible<T>::value, "AudioDriver's entity type has to be default constructible - it's stored by value "
+		"with every sound, and sounds that aren't attached to an entity hold a default constructed one. Use a handle or pointer to the entity.");
+	static_assert(std::is_copy_assignable<T>::value, "AudioDriver's entity type has to be copy assignable, since sounds get moved around in "
+		"the voice table. Use a handle or pointer to the entity.");
 	public:
-		//utility structure for managing sound instances
-		struct _SoundInstance {
-			T id;
-			std::shared_ptr<AudioSource> src;
-			bool overrideValidLoop = false;
+		//An entry in a sound table. The file name gets resolved into a full path once, when the sound gets registered.
+		struct _SoundEntry {
+			std::string name; //kept around to catch two names hashing to the same key
+			std::string path;
+			ALuint buf = 0; //0 until the sound is loaded, and again if its buffer gets evicted
+			bool loading = false;
+			std::shared_future<ALuint> pending;
+		};
+		//Timings of finished loads, kept while any preload of the bank is running so it can report on its own files.
+		struct _LoadLog {
+			uint32_t preloads = 0;
+			std::vector<AudioBuffer::LoadTiming> timings;
+		};
+		//Results from a bulk preload. Files are sorted slowest decode first so the worst offenders are easy to spot.
+		struct PreloadReport {
+			size_t requested = 0;
+			size_t loaded = 0;
+			size_t failed = 0;
+			float totalMs = 0.f;
+			std::vector<AudioBuffer::LoadTiming> files;
+			//Overall decode throughput across the files that were loaded, in MB of PCM per second of decoding.
+			float decodeMBps() const
+			{
+				size_t bytes = 0;
+				float ms = 0.f;
+				for (const auto& file : files) {
+					bytes += file.bytes;
+					ms += file.decodeMs;
+				}
+				return ms > 0.f ? (float)bytes / (ms * 1000.f) : 0.f;
+			}
+		};
+		//What to do when a game sound gets played before its file has finished loading in the background.
+		enum class LoadingPolicy {
+			DEFER_START, //the voice waits for the load to finish and then starts from the beginning
+			SKIP //the sound just doesn't play
+		};
+		//Counters for the virtual voice system.
+		struct VoiceStats {
+			size_t realVoices = 0;
+			size_t virtualVoices = 0;
+			size_t culledVoices = 0; //voices out of earshot as of the last update (past their max distance, or the maximum distance)
+			uint64_t promotions = 0;
+			uint64_t demotions = 0;
+			float updateMs = 0.f; //how long the last gameSoundUpdate took
+			float peakUpdateMs = 0.f;
+			uint64_t droppedCommands = 0; //calls that didn't fit in the audio thread's queue
 		};
 		/*
 		Initializes the audio driver.
@@ -63,9 +144,428 @@ class AudioDriver
 				return AlVec3f(vel.X, vel.Y, vel.Z);
 			}
 		*/
+		//Only there for the default traits, which wrap these functions.
+		template<class Traits = EntityTraits, class = std::enable_if_t<std::is_same<Traits, FunctionEntityTraits<T>>::value>>
 		AudioDriver(std::function<AlVec3f(T)> velocityFunc, std::function<AlVec3f(T)> positionFunc, std::function<bool(T)> validityFunc, 
 			float speedOfSound = 331.5f, float dopplerFactor = 1.f) 
-			: m_velocityFunc(velocityFunc), m_positionFunc(positionFunc), m_validityFunc(validityFunc)
+			: m_traits(velocityFunc, positionFunc, validityFunc)
+		{
+			m_init(speedOfSound, dopplerFactor);
+		}
+		//Initializes the audio driver with a traits type that knows how to look at your entities. See EntityTraits.h.
+		explicit AudioDriver(EntityTraits traits, float speedOfSound = 331.5f, float dopplerFactor = 1.f)
+			: m_traits(traits)
+		{
+			m_init(speedOfSound, dopplerFactor);
+		}
+		//Initializes the audio driver with default constructed traits. Not there for the default traits, which are useless without their
+		//functions - use the constructor above that takes them instead.
+		template<class Traits = EntityTraits, class = std::enable_if_t<!std::is_same<Traits, FunctionEntityTraits<T>>::value>>
+		AudioDriver()
+			: m_traits()
+		{
+			m_init(331.5f, 1.f);
+		}
+		//Hands any sources that are still playing back to the pool before the pool goes away.
+		~AudioDriver()
+		{
+			stopAudioThread();
+			for (auto src : curGameSounds.src) {
+				if (src) m_sourcePool.release(src);
+			}
+			curGameSounds.clear();
+			for (auto src : curMenuSounds) {
+				menuSounds.release(src->getBuffer());
+				m_sourcePool.release(src);
+			}
+			curMenuSounds.clear();
+			delete musicSource;
+		}
+
+
+		//This plays a sound from the given source in the game and registers the source. Returns a handle to the voice if you need to track it.
+		//This sound is attached to an entity, and will stop looping once the entity stops being valid.
+		//Every sound starts out as a virtual voice, and the driver hands sources to whichever voices are loudest, so the actual source is
+		//never exposed. Use the handle with setVoiceGain, stopVoice and so on instead; those do nothing once the sound is over.
+		VoiceHandle playGameSound(const T& ent, std::string fname, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		{
+			return playGameSound(ent, registerSound(fname), gain, refDist, maxDist, loop);
+		}
+		//Same as above, but with a name hashed at compile time, e.g. playGameSound(ent, "impact_1.ogg"_snd)
+		VoiceHandle playGameSound(const T& ent, SoundName name, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		{
+			return playGameSound(ent, registerSound(name), gain, refDist, maxDist, loop);
+		}
+		//Same as above, but plays a sound that was registered ahead of time, so there's no string hashing on the play.
+		VoiceHandle playGameSound(const T& ent, SoundId sound, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		{
+			_Command cmd;
+			cmd.type = _Command::PLAY_ENTITY;
+			cmd.sound = sound.index;
+			cmd.entity = ent;
+			cmd.flags = VoiceTable<T>::TRACKS_ENTITY | (loop ? VoiceTable<T>::LOOP : 0);
+			cmd.values[0] = gain;
+			cmd.values[1] = refDist;
+			cmd.values[2] = maxDist;
+			return m_submitPlay(cmd);
+		}
+
+		//This plays a sound from the given source in the game and registers the source. Returns a handle to the voice if you need to track it.
+		//This plays the sound explicitly from the given position, and is not attached to an entity.
+		VoiceHandle playGameSound(AlVec3f position, std::string fname, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		{
+			return playGameSound(position, registerSound(fname), gain, refDist, maxDist, loop);
+		}
+		//Same as above, but with a name hashed at compile time.
+		VoiceHandle playGameSound(AlVec3f position, SoundName name, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		{
+			return playGameSound(position, registerSound(name), gain, refDist, maxDist, loop);
+		}
+		//Same as above, but plays a sound that was registered ahead of time, so there's no string hashing on the play.
+		VoiceHandle playGameSound(AlVec3f position, SoundId sound, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		{
+			_Command cmd;
+			cmd.type = _Command::PLAY_POSITION;
+			cmd.sound = sound.index;
+			cmd.pos = position;
+			cmd.flags = loop ? (VoiceTable<T>::LOOP | VoiceTable<T>::OVERRIDE_VALID_LOOP) : 0;
+			cmd.values[0] = gain;
+			cmd.values[1] = refDist;
+			cmd.values[2] = maxDist;
+			return m_submitPlay(cmd);
+		}
+
+		//Plays a menu sound effect.
+		void playMenuSound(std::string fname)
+		{
+			playMenuSound(registerMenuSound(fname));
+		}
+		//Plays a menu sound effect with a name hashed at compile time.
+		void playMenuSound(SoundName name)
+		{
+			playMenuSound(registerMenuSound(name));
+		}
+		//Plays a menu sound effect that was registered ahead of time.
+		void playMenuSound(SoundId sound)
+		{
+			_Command cmd;
+			cmd.type = _Command::PLAY_MENU;
+			cmd.sound = sound.index;
+			m_submit(cmd);
+		}
+		//Resolves a game sound's file name once and hands back a SoundId that can be played without any string work.
+		//Registering the same name again gives back the same SoundId. Uses the game sound path as it is at the time of registering.
+		//Returns an invalid SoundId if the name's hash collides with a different name that's already registered.
+		SoundId registerSound(const std::string& fname) { return m_register(loadedGameSounds, m_gameSoundTable, m_gameSoundPath, m_soundName(fname)); }
+		//Same as above, but with a name hashed at compile time. Once the name is registered this is an integer lookup plus a comparison
+		//of the name against the registered one, which doesn't allocate.
+		SoundId registerSound(SoundName name) { return m_register(loadedGameSounds, m_gameSoundTable, m_gameSoundPath, name); }
+		//Same as registerSound, but for menu sounds.
+		SoundId registerMenuSound(const std::string& fname) { return m_register(loadedMenuSounds, m_menuSoundTable, m_menuSoundPath, m_soundName(fname)); }
+		//Same as registerSound, but for menu sounds.
+		SoundId registerMenuSound(SoundName name) { return m_register(loadedMenuSounds, m_menuSoundTable, m_menuSoundPath, name); }
+		//Loads every game sound in the list, decoding them in parallel across the worker pool. Doesn't return until all of them are resident.
+		//The progress function (if any) gets called with how many files are done out of the total every time more of them finish.
+		//Useful for scene start, so that playGameSound never has to wait on a load. The audio thread only gets locked out for the moments
+		//it takes to hand finished loads to OpenAL, so sounds that are already playing keep going while this waits.
+		PreloadReport preloadGameSounds(const std::vector<std::string>& fnames, std::function<void(size_t, size_t)> progress = nullptr)
+		{
+			std::vector<SoundId> sounds;
+			size_t invalid = 0; //names that couldn't be registered
+			for (const auto& fname : fnames) {
+				SoundId id = registerSound(fname);
+				if (id.isValid()) sounds.push_back(id);
+				else ++invalid;
+			}
+			return m_preload(gameSounds, m_gameSoundTable, m_loadingGameSounds, m_gameLoadLog, sounds, invalid, progress);
+		}
+		//Same as preloadGameSounds, but for menu sounds.
+		PreloadReport preloadMenuSounds(const std::vector<std::string>& fnames, std::function<void(size_t, size_t)> progress = nullptr)
+		{
+			std::vector<SoundId> sounds;
+			size_t invalid = 0; //names that couldn't be registered
+			for (const auto& fname : fnames) {
+				SoundId id = registerMenuSound(fname);
+				if (id.isValid()) sounds.push_back(id);
+				else ++invalid;
+			}
+			return m_preload(menuSounds, m_menuSoundTable, m_loadingMenuSounds, m_menuLoadLog, sounds, invalid, progress);
+		}
+		//Plays music. Will halt any present music.
+		//The track is streamed from disk a chunk at a time on a background thread, so it starts right away regardless of how long it is.
+		void playMusic(std::string fname)
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			musicSource->play(m_musicPath + fname);
+		}
+		//Stops the music.
+		void stopMusic()
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			musicSource->stop();
+		}
+		//Updates all the sounds in the game to be deleted and shuffled around.
+		//Virtual voices keep advancing their playback, and the most audible voices get promoted to real sources while the rest are demoted.
+		//ALWAYS CALL setListenerPosition PRIOR TO USING THIS UPDATE
+		//With the audio thread running, the audio thread does all of this by itself and this just picks up the handles of finished sounds.
+		void gameSoundUpdate()
+		{
+			if (m_threaded) {
+				m_collectHandles();
+				return;
+			}
+			m_gameUpdate();
+			m_reclaimHandles();
+		}
+		//Wipes the data buffer for in-game sound effects. Useful for ending a scene and returning to menus.
+		void cleanupGameSounds()
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_setListener(AlVec3f(0, 0, 0), AlVec3f(0.f, 1.f, 0.f), AlVec3f(0.f, 0.f, -1.f), AlVec3f(0.f, 0.f, 0.f));
+			m_flushListener();
+			for (auto& src : curGameSounds.src) {
+				if (src) m_sourcePool.release(src);
+				src = nullptr;
+			}
+			curGameSounds.clear();
+			m_reclaimHandles();
+			m_rankedVoices.clear();
+			m_lastGameUpdate = std::chrono::steady_clock::now(); //the next scene starts from a clean slate, not from when this one last updated
+			m_voiceStats.realVoices = 0;
+			m_voiceStats.virtualVoices = 0;
+
+			gameSounds.removeAllAudio();
+			for (auto& entry : m_gameSoundTable) { //registered SoundIds stay valid, they'll just load again the next time they play
+				entry.buf = 0;
+				entry.loading = false;
+				entry.pending = std::shared_future<ALuint>();
+			}
+			m_loadingGameSounds.clear();
+		}
+		VoiceTable<T> curGameSounds;
+		std::vector<AudioSource*> curMenuSounds;
+
+		//Runs an update for menu sounds. Unlike the game sounds, this does not track entities or position.
+		//Menu sounds and music are relative to the listener, so they stay on top of it wherever it is and inGame makes no difference anymore.
+		//It's only kept so existing calls still compile.
+		void menuSoundUpdate(bool inGame = false)
+		{
+			(void)inGame;
+			if (!m_threaded) {
+				m_menuUpdate();
+				return;
+			}
+			m_collectHandles();
+		}
+		//Sets the listener position, including up values and forward velocity.
+		//This only gets sent to OpenAL with the rest of the frame's changes during gameSoundUpdate or menuSoundUpdate.
+		void setListenerPosition(AlVec3f pos, AlVec3f up = AlVec3f(0.f, 1.f, 0.f), AlVec3f forward = AlVec3f(0.f, 0.f, -1.f), AlVec3f vel = AlVec3f(0.f, 0.f, 0.f))
+		{
+			_Command cmd;
+			cmd.type = _Command::SET_LISTENER;
+			cmd.pos = pos;
+			cmd.up = up;
+			cmd.forward = forward;
+			cmd.vel = vel;
+			m_submit(cmd);
+		}
+		//Sets the global gains for sound effects and the various types of sound.
+		void setGains(float master, float music, float game, float menu)
+		{
+			_Command cmd;
+			cmd.type = _Command::SET_GAINS;
+			cmd.values[0] = master;
+			cmd.values[1] = music;
+			cmd.values[2] = game;
+			cmd.values[3] = menu;
+			m_submit(cmd);
+		}
+		/*
+		Moves all of the driver's work onto a dedicated audio thread that runs the updates by itself at the given rate, so audio no longer
+		depends on the game's frame rate. From then on, playing sounds, moving the listener, setting gains and the voice controls just
+		queue up a small command for the audio thread and return straight away, and the audio thread is the only one talking to OpenAL.
+		The position, velocity and validity functions get called from the audio thread, so they have to be safe to call from there, and
+		since they run while the audio thread holds the driver's lock they must never call back into the driver.
+		Registering, cleanup and the rest of the setup calls still work from the game thread, but they lock the audio thread out while they
+		run. Preloading only locks it out while finished loads get handed to OpenAL. A menu sound played for the first time gets loaded in the
+		background and starts once it's ready, so the audio thread never has to sit through a decode.
+		*/
+		void startAudioThread(float updatesPerSecond = 100.f)
+		{
+			if (m_threaded) return;
+			if (!(updatesPerSecond > 0.f) || !std::isfinite(updatesPerSecond)) {
+				std::cerr << "Audio thread needs a positive update rate, got " << updatesPerSecond << ". Not starting it.\n";
+				return;
+			}
+			if (!m_commands) m_commands = std::make_unique<SpscRing<_Command, COMMAND_QUEUE_SIZE>>();
+			if (!m_finishedHandles) m_finishedHandles = std::make_unique<SpscRing<VoiceHandle, COMMAND_QUEUE_SIZE>>();
+			auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.f / updatesPerSecond));
+			m_stopThread = false;
+			m_threaded = true;
+			m_thread = std::thread(&AudioDriver::m_threadMain, this, period);
+		}
+		//Stops the audio thread and goes back to running everything on the calling thread. Anything still queued for the audio thread runs first.
+		void stopAudioThread()
+		{
+			if (!m_threaded) return;
+			m_stopThread = true;
+			m_thread.join();
+			m_threaded = false;
+
+			_Command cmd;
+			while (m_commands->pop(cmd)) m_execute(cmd);
+			m_collectHandles();
+			m_reclaimHandles();
+		}
+		//Returns whether the audio thread is running.
+		bool isThreaded() const { return m_threaded; }
+
+		//Sets how many bytes of decoded game sounds can stay loaded at once. Past this, the least recently used game sounds that aren't
+		//playing or pinned get unloaded. 0 means no limit, which is the default.
+		void setGameSoundBudget(size_t bytes) { std::lock_guard<std::mutex> lock(m_stateMutex); gameSounds.setBudget(bytes); }
+		//Same as setGameSoundBudget, but for menu sounds.
+		void setMenuSoundBudget(size_t bytes) { std::lock_guard<std::mutex> lock(m_stateMutex); menuSounds.setBudget(bytes); }
+		//Pins a game sound so that it never gets unloaded to make room under the budget, or unpins it.
+		void pinGameSound(std::string fname, bool pinned = true) { std::lock_guard<std::mutex> lock(m_stateMutex); gameSounds.pin(m_gameSoundPath + fname, pinned); }
+		//Pins a menu sound so that it never gets unloaded to make room under the budget, or unpins it.
+		void pinMenuSound(std::string fname, bool pinned = true) { std::lock_guard<std::mutex> lock(m_stateMutex); menuSounds.pin(m_menuSoundPath + fname, pinned); }
+		//Sets whether game sounds get decoded to 16-bit or 32-bit float samples. Float needs AL_EXT_FLOAT32 and falls back to 16-bit without it.
+		//Only affects sounds loaded after this. Default: PRECISION_INT16
+		void setGameSoundPrecision(AudioBuffer::SamplePrecision precision) { std::lock_guard<std::mutex> lock(m_stateMutex); m_setPrecision(gameSounds, precision); }
+		//Same as setGameSoundPrecision, for menu sounds.
+		void setMenuSoundPrecision(AudioBuffer::SamplePrecision precision) { std::lock_guard<std::mutex> lock(m_stateMutex); m_setPrecision(menuSounds, precision); }
+		//Sets whether stereo game sounds get mixed down to mono when they load, so that they actually get spatialized. Menu sounds and music
+		//always stay as they are. Only affects sounds loaded after this. Default: True
+		void setGameSoundDownmix(bool downmix) { std::lock_guard<std::mutex> lock(m_stateMutex); gameSounds.setDownmix(downmix); }
+		//Sets whether game and menu sounds get resampled to the device's mixing rate when they load, with a much better filter than OpenAL
+		//can afford while mixing. Sounds that already match, or that play at a random pitch, still get resampled while mixing anyway, so this
+		//is best paired with setRandomPitch(false). Costs load time, and memory for anything recorded below the device rate. Music isn't
+		//affected. Only affects sounds loaded after this. Default: False
+		void resampleToDeviceRate(bool resample) { std::lock_guard<std::mutex> lock(m_stateMutex); int rate = resample ? m_deviceRate : 0; gameSounds.setResampleRate(rate); menuSounds.setResampleRate(rate); }
+		//Returns the rate the device mixes at, or 0 if it couldn't be asked.
+		int getDeviceRate() const { return m_deviceRate; }
+		//Returns resident bytes, evictions, and the hit rate for game sounds.
+		AudioBuffer::CacheStats getGameSoundCacheStats() const { std::lock_guard<std::mutex> lock(m_stateMutex); return gameSounds.getCacheStats(); }
+		//Returns resident bytes, evictions, and the hit rate for menu sounds.
+		AudioBuffer::CacheStats getMenuSoundCacheStats() const { std::lock_guard<std::mutex> lock(m_stateMutex); return menuSounds.getCacheStats(); }
+		//Turns on the on-disk cache of decoded audio. After a file is decoded once, its raw PCM gets written to the given directory and later
+		//loads read it back instead of decoding the .ogg again. Entries for files that have changed are dropped automatically, and the least
+		//recently used entries are deleted to keep the directory under maxBytes (0 for no limit). An empty directory turns the cache off.
+		bool usePcmCache(std::string dir, uint64_t maxBytes = 512ull * 1024 * 1024) { std::lock_guard<std::mutex> lock(m_stateMutex); return m_pcmCache.setDirectory(dir, maxBytes); }
+		//Returns the hit, miss, stale, and eviction counters for the PCM cache.
+		PcmCache::Stats getPcmCacheStats() { std::lock_guard<std::mutex> lock(m_stateMutex); return m_pcmCache.getStats(); }
+		//Mounts a packed sound bank for game sounds. Sounds in the bank are looked up by their name relative to the game sound path,
+		//so call this after setPaths. Banks are memory mapped and take priority over loose files.
+		bool mountGameSoundBank(std::string path) { std::lock_guard<std::mutex> lock(m_stateMutex); return gameSounds.mountBank(path, m_gameSoundPath); }
+		//Mounts a packed sound bank for menu sounds. Same rules as mountGameSoundBank.
+		bool mountMenuSoundBank(std::string path) { std::lock_guard<std::mutex> lock(m_stateMutex); return menuSounds.mountBank(path, m_menuSoundPath); }
+		//Sets the paths to look for the various types of sound - music, menu, and gains. Default is no path.
+		void setPaths(std::string music, std::string menus, std::string game) { m_musicPath = music; m_menuSoundPath = menus; m_gameSoundPath = game; }
+		//If this is enabled, the game's sounds will vary in pitch by ~.5f to make them all sound less monotonous.
+		//Default: True
+		void setRandomPitch(bool random = true) { std::lock_guard<std::mutex> lock(m_stateMutex); m_randomPitchOnGameSounds = random; }
+		//Sets the maximum distance a new sound can be spawned at. Default: 1500
+		//If the sound is further away from the listener than this distance, it will not play. Only works if useMaximumDistance is set to true.
+		void setMaximumDistance(float max) { std::lock_guard<std::mutex> lock(m_stateMutex); m_maximumDistance = max; m_updateMaxDistance(); }
+		//Should this driver use a maximum distance to allow sounds to be played at? Default: True
+		void useMaximumDistance(bool maxDist = true) { std::lock_guard<std::mutex> lock(m_stateMutex); m_useMaximumDistance = maxDist; m_updateMaxDistance(); }
+		//Returns the driver's copy of the listener, as of the last update. See AudioListener for the helpers that come with it.
+		AudioListener getListener() const { std::lock_guard<std::mutex> lock(m_stateMutex); return m_listener; }
+		//Sets what happens when a game sound is played while its file is still loading in the background. Default: DEFER_START
+		void setLoadingPolicy(LoadingPolicy policy) { std::lock_guard<std::mutex> lock(m_stateMutex); m_loadingPolicy = policy; }
+		//Sets the maximum number of game sounds that can hold a real source at once. Everything past this is tracked virtually. Default: 64
+		void setMaxRealVoices(size_t max) { std::lock_guard<std::mutex> lock(m_stateMutex); m_maxRealVoices = max; }
+		//Gives the default traits a function that fills in every tracked entity at once. See EntityBatch in EntityTraits.h.
+		//Only there for the default traits; a traits type of your own can just have a query function.
+		template<class Traits = EntityTraits, class = std::enable_if_t<std::is_same<Traits, FunctionEntityTraits<T>>::value>>
+		void setEntityBatchQuery(std::function<void(EntityBatch<T>&)> batchFunc)
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_traits.m_batchFunc = batchFunc;
+		}
+		//Returns how many voices are currently real and virtual, and how often voices have been swapped in and out.
+		VoiceStats getVoiceStats() const
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			VoiceStats stats = m_voiceStats;
+			stats.droppedCommands = m_droppedCommands;
+			return stats;
+		}
+		//Returns the hit, miss and exhaustion counters for the pool of sources used by game and menu sounds.
+		AudioSourcePool::Stats getSourcePoolStats() const { std::lock_guard<std::mutex> lock(m_stateMutex); return m_sourcePool.getStats(); }
+		//Returns how many AL calls the sources have made, and how many they skipped because the value hadn't changed.
+		AudioSource::CallStats getSourceCallStats() const { std::lock_guard<std::mutex> lock(m_stateMutex); return AudioSource::getCallStats(); }
+
+		//Returns whether the sound behind the handle is still playing (real or virtual).
+		//With the audio thread running this lags behind by up to one audio update.
+		bool isVoicePlaying(VoiceHandle voice) const
+		{
+			if (m_threaded) return m_handles.isLive(voice);
+			return curGameSounds.find(voice) != VoiceTable<T>::INVALID;
+		}
+		//Stops the sound behind the handle straight away. Does nothing if the sound is already over.
+		void stopVoice(VoiceHandle voice)
+		{
+			_Command cmd;
+			cmd.type = _Command::STOP_VOICE;
+			cmd.voice = voice;
+			m_submit(cmd);
+		}
+		//Sets the gain of the sound behind the handle. This gets scaled by the game gain like everything else.
+		void setVoiceGain(VoiceHandle voice, float gain)
+		{
+			_Command cmd;
+			cmd.type = _Command::SET_VOICE_GAIN;
+			cmd.voice = voice;
+			cmd.values[0] = gain;
+			m_submit(cmd);
+		}
+		//Sets the pitch of the sound behind the handle.
+		void setVoicePitch(VoiceHandle voice, float pitch)
+		{
+			_Command cmd;
+			cmd.type = _Command::SET_VOICE_PITCH;
+			cmd.voice = voice;
+			cmd.values[0] = pitch;
+			m_submit(cmd);
+		}
+		//Sets whether the sound behind the handle loops. Turning looping off lets the sound play out to the end of the buffer.
+		void setVoiceLoop(VoiceHandle voice, bool loop)
+		{
+			_Command cmd;
+			cmd.type = _Command::SET_VOICE_LOOP;
+			cmd.voice = voice;
+			cmd.flags = loop ? VoiceTable<T>::LOOP : 0;
+			m_submit(cmd);
+		}
+		//Moves the sound behind the handle. Sounds attached to an entity get moved back to the entity on the next update.
+		void setVoicePosition(VoiceHandle voice, AlVec3f pos)
+		{
+			_Command cmd;
+			cmd.type = _Command::SET_VOICE_POSITION;
+			cmd.voice = voice;
+			cmd.pos = pos;
+			m_submit(cmd);
+		}
+
+		//Hard cap on the number of sources the driver will pregenerate, regardless of what the device claims to support.
+		static constexpr size_t MAX_POOLED_SOURCES = 256;
+		//Number of game sounds the driver makes room for up front. Playing more than this is fine, it just means a reallocation.
+		static constexpr size_t INITIAL_VOICE_CAPACITY = 1024;
+		//Least number of sources checked each update to see if they've stopped, when the driver doesn't support AL_SOFT_events. With more
+		//sources in use, a quarter of them get checked, so any one of them is seen within four updates.
+		static constexpr size_t POLLED_SOURCES_PER_UPDATE = 16;
+		//Number of commands that can be waiting for the audio thread before calls start getting dropped.
+		static constexpr size_t COMMAND_QUEUE_SIZE = 4096;
+		//Longest time a single game update will advance virtual voices by, in seconds. Longer gaps count as the game being paused.
+		static constexpr float MAX_UPDATE_STEP = .25f;
+		//How much louder a virtual voice has to be than a real voice that's dropped out of the top voices before it takes its source.
+		static constexpr float PROMOTION_MARGIN = 1.25f;
+		//How long a voice keeps its source before a louder voice can take it, in seconds.
+		static constexpr float MIN_REAL_SECONDS = .25f;
+	private:
+		//Opens the device and sets everything up. Shared by the constructors.
+		void m_init(float speedOfSound, float dopplerFactor)
 		{
 			device = alcOpenDevice(nullptr);
 			if (device) {
@@ -73,6 +573,9 @@ class AudioDriver
 				if (context) {
 					alcMakeContextCurrent(context);
 				}
+				ALCint rate = 0;
+				alcGetIntegerv(device, ALC_FREQUENCY, 1, &rate);
+				if (alcGetError(device) == ALC_NO_ERROR && rate > 0) m_deviceRate = rate;
 			}
 			const ALCchar* name = nullptr;
 			if (alcIsExtensionPresent(device, "ALC_ENUMERATE_ALL_EXT"))
@@ -80,214 +583,781 @@ class AudioDriver
 			if (!name || alcGetError(device) != AL_NO_ERROR)
 				name = alcGetString(device, ALC_DEVICE_SPECIFIER);
 
+			m_ext.load(context);
+			m_ext.startSourceEvents();
 			alDistanceModel(AL_LINEAR_DISTANCE_CLAMPED);
 			alSpeedOfSound(speedOfSound);
 			alDopplerFactor(dopplerFactor);
 
-			printf("Opened audio device: %s \n", name);
-			musicSource = new AudioSource;
+			printf("Opened audio device: %s (%d Hz) \n", name, m_deviceRate);
+
+			//the music gets its own source, so the pool gets whatever is left over from the device limits
+			ALCint monoSources = 0, stereoSources = 0;
+			alcGetIntegerv(device, ALC_MONO_SOURCES, 1, &monoSources);
+			alcGetIntegerv(device, ALC_STEREO_SOURCES, 1, &stereoSources);
+			size_t poolSize = (size_t)monoSources + (size_t)stereoSources;
+			if (poolSize == 0 || poolSize > MAX_POOLED_SOURCES) poolSize = MAX_POOLED_SOURCES;
+			if (poolSize > 1) --poolSize;
+			poolSize = m_sourcePool.init(poolSize, poolSize);
+			printf("Generated %zu pooled audio sources \n", poolSize);
+			curGameSounds.reserve(INITIAL_VOICE_CAPACITY);
+			curMenuSounds.reserve(poolSize);
+			m_rankedVoices.reserve(INITIAL_VOICE_CAPACITY);
+			m_batchIndex.reserve(INITIAL_VOICE_CAPACITY);
+			m_batchEntities.reserve(INITIAL_VOICE_CAPACITY);
+
+			gameSounds.setWorkerPool(&m_workers);
+			menuSounds.setWorkerPool(&m_workers);
+			gameSounds.setPcmCache(&m_pcmCache);
+			menuSounds.setPcmCache(&m_pcmCache);
+			gameSounds.setExtensions(&m_ext);
+			gameSounds.setDownmix(true); //game sounds get played positionally, which OpenAL only does for mono
+			menuSounds.setExtensions(&m_ext);
+			gameSounds.setEvictionCallback([this](ALuint buf) { m_forgetBuffer(m_gameSoundTable, buf); });
+			menuSounds.setEvictionCallback([this](ALuint buf) { m_forgetBuffer(m_menuSoundTable, buf); });
+
+			musicSource = new AudioStream;
 			musicSource->setGain(musicGain);
 			musicSource->setLoop(true);
+			m_make2D(musicSource);
 		}
-
-
-		//This plays a sound from the given source in the game and registers the source. Returns the source if you need to track it.
-		//This sound is attached to an entity, and will stop if the validityFunc for this entity fails.
-		std::shared_ptr<AudioSource> playGameSound(T ent, std::string fname, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		//Loads the buffer for a new voice and registers it under the given handle. The voice gets a real source straight away if there's room
+		//under the cap, otherwise it starts out virtual and waits for the next update to see if it's loud enough.
+		//If the sound can't play, the handle gets discarded.
+		void m_play(VoiceHandle handle, SoundId sound, const T& ent, uint8_t flags, const AlVec3f& pos, const AlVec3f& vel,
+			float gain, float refDist, float maxDist)
 		{
-			AlVec3f srcPos = m_positionFunc(ent);
-			ALfloat lPos[3] = { 0.f, 0.f, 0.f };
-			alGetListener3f(AL_POSITION, &lPos[0], &lPos[1], &lPos[2]);
-			AlVec3f listener(lPos[0], lPos[1], -lPos[2]);
-
-			if (m_useMaximumDistance) {
-				if (std::abs((srcPos - listener).length()) >= m_maximumDistance) {
-					return std::shared_ptr<AudioSource>(); //returns a null if the sound is more than a kilometer away
+			VoiceTable<T>& v = curGameSounds;
+			if (!m_listener.inRange(pos)) { //doesn't play if the sound is more than a kilometer away
+				v.discard(handle);
+				return;
+			}
+			if (sound.index >= m_gameSoundTable.size()) {
+				v.discard(handle);
+				return;
+			}
+			_SoundEntry& entry = m_gameSoundTable[sound.index];
+			bool hit = entry.buf != 0;
+			if (!hit && !entry.loading) { //not loaded yet, so kick off the load in the background rather than hitching the frame
+				m_requestLoad(gameSounds, m_gameSoundTable, m_loadingGameSounds, sound);
+				if (!entry.loading && entry.buf == 0) {
+					v.discard(handle);
+					return;
 				}
 			}
+			if (entry.loading) {
+				if (m_loadingPolicy == LoadingPolicy::SKIP) {
+					v.discard(handle);
+					return;
+				}
+				flags |= VoiceTable<T>::LOADING;
+			}
+
+			v.insert(handle);
+			uint32_t i = (uint32_t)v.size() - 1;
+			v.entity[i] = ent;
+			v.flags[i] = flags;
+			v.setPos(i, pos);
+			v.setVel(i, vel);
+			v.gain[i] = gain;
+			v.refDist[i] = refDist;
+			v.maxDist[i] = maxDist;
+			v.sound[i] = sound.index;
+			v.buf[i] = entry.buf;
+			v.length[i] = entry.buf ? gameSounds.getLength(entry.buf) : 0.f;
+			if (entry.buf) gameSounds.acquire(entry.buf, hit); //the voice holds onto the buffer until it's done, so it can't get evicted
+			v.pitch[i] = m_randomPitchOnGameSounds ? std::uniform_real_distribution<float>(.75f, 1.25f)(randGen) : 1.f;
+			v.audibility[i] = m_audibility(i);
 
-			ALuint buf = 0;
-			if (loadedGameSounds.find(fname) != loadedGameSounds.end()) {
-				buf = loadedGameSounds.at(fname);
+			++m_voiceStats.virtualVoices;
+			if (!(flags & VoiceTable<T>::LOADING) && m_voiceStats.realVoices < m_maxRealVoices && v.audibility[i] > 0.f) {
+				m_promote(i);
 			}
-			else {
-				buf = gameSounds.loadAudio(m_gameSoundPath + fname);
-				if (buf == 0) return nullptr;
-				loadedGameSounds[fname] = buf;
+		}
+		//Hashes a name at runtime.
+		static SoundName m_soundName(const std::string& fname) { return SoundName{ fnv1a64(fname.data(), fname.size()), fname.data(), fname.size() }; }
+		//Looks up a name in the sound table, adding it if it isn't there yet. A name that's already there gets compared against the one
+		//that was registered, to catch two names with the same hash.
+		SoundId m_register(std::unordered_map<uint64_t, SoundId>& ids, std::vector<_SoundEntry>& table, const std::string& path,
+			const SoundName& name)
+		{
+			auto it = ids.find(name.key);
+			if (it != ids.end()) {
+				const std::string& known = table[it->second.index].name;
+				if (known.size() != name.len || memcmp(known.data(), name.str, name.len) != 0) {
+					std::cerr << "Sound name " << std::string(name.str, name.len) << " has the same hash as " << known << ", not registering it.\n";
+					return SoundId();
+				}
+				return it->second;
 			}
-			//also needs to register the audio source
-			AudioSource* src = new AudioSource;
-
-			src->setVel(m_velocityFunc(ent));
 
-			src->setRefDist(refDist);
-			src->setMaxDist(maxDist);
-			src->setGain(gain * gameGain);
-			src->setLoop(loop);
+			std::string fname(name.str, name.len);
+			std::lock_guard<std::mutex> lock(m_stateMutex); //the audio thread could be reading the table
+			SoundId id;
+			id.index = (uint32_t)table.size();
+			_SoundEntry entry;
+			entry.name = fname;
+			entry.path = path + fname;
+			table.push_back(entry);
+			ids.emplace(name.key, id);
+			return id;
+		}
+		//Runs one update of the game sounds. See gameSoundUpdate.
+		void m_gameUpdate()
+		{
+			auto now = std::chrono::steady_clock::now();
+			//a long gap means the game wasn't updating (sitting in menus, loading), and virtual voices shouldn't skip ahead through all of it
+			float dt = std::min(std::chrono::duration<float>(now - m_lastGameUpdate).count(), MAX_UPDATE_STEP);
+			m_lastGameUpdate = now;
 
-			src->setPitch(m_randomPitchOnGameSounds ? std::uniform_real_distribution<float>(.75f, 1.25f)(randGen) : 1.f);
+			m_pumpLoads(gameSounds, m_gameSoundTable, m_loadingGameSounds, m_gameLoadLog);
 
-			src->play(buf);
-			_SoundInstance inst;
-			inst.id = ent;
-			inst.src = std::shared_ptr<AudioSource>(src);
+			m_updateSourceStates();
+			//everything the update changes goes out to OpenAL in one batch at the end, so the mixer sees the whole frame at once
+			m_ext.beginBatch();
+			m_rankedVoices.clear();
+			VoiceTable<T>& v = curGameSounds;
+			uint32_t i = 0;
+			while (i < v.size()) { //removing a voice moves the last one into its spot, so i only moves on when the voice stays
+				bool justLoaded = false;
+				if (v.flags[i] & VoiceTable<T>::LOADING) {
+					if (v.buf[i] == 0) { //m_collectGameLoads hands the buffer over as soon as the load is collected
+						if (m_gameSoundTable[v.sound[i]].loading) {
+							++i;
+							continue;
+						}
+						--m_voiceStats.virtualVoices; //the load failed
+						v.erase(i);
+						continue;
+					}
+					v.flags[i] &= ~VoiceTable<T>::LOADING;
+					justLoaded = true;
+				}
+				if (v.src[i]) {
+					if (v.src[i]->hasStopped()) { //if the sound is finished we're done here
+						m_removeVoice(i);
+						continue;
+					}
+					v.realTime[i] += dt;
+				}
+				else if (!justLoaded) {
+					v.playTime[i] += dt * v.pitch[i];
+					if (v.playTime[i] >= v.length[i]) {
+						if (!(v.flags[i] & VoiceTable<T>::LOOP) || v.length[i] <= 0.f) {
+							m_removeVoice(i);
+							continue;
+						}
+						v.playTime[i] = std::fmod(v.playTime[i], v.length[i]);
+					}
+				}
+				++i;
+			}
+			m_updateEntities();
+			//one vectorized pass works out how loud every voice is and which ones are out of earshot
+			m_voiceCull.resize(v.size());
+			computeAudibility(m_emitters(0, v.size()), m_listener.position, gameGain, m_listener.maxDistSq, v.audibility.data(), m_voiceCull.data());
+			m_voiceStats.culledVoices = 0;
+			for (uint32_t i = 0; i < v.size(); ++i) {
+				if (v.flags[i] & VoiceTable<T>::LOADING) continue;
+				if (m_voiceCull[i] != EMITTER_AUDIBLE) ++m_voiceStats.culledVoices;
+				m_rankedVoices.push_back(i);
+			}
+			m_updateVoiceRanking();
+			for (uint32_t i = 0; i < v.size(); ++i) {
+				if (!v.src[i]) continue;
+				if (v.flags[i] & VoiceTable<T>::TRACKS_ENTITY) {
+					v.src[i]->setPos(v.getPos(i));
+					v.src[i]->setVel(v.getVel(i));
+				}
+				v.src[i]->flush(); //only whatever actually changed goes out
+			}
+			m_flushListener();
+			m_ext.endBatch();
 
-			curGameSounds.push_back(inst);
-			return inst.src;
+			m_voiceStats.updateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - now).count();
+			if (m_voiceStats.updateMs > m_voiceStats.peakUpdateMs) m_voiceStats.peakUpdateMs = m_voiceStats.updateMs;
 		}
-
-		//This plays a sound from the given source in the game and registers the source. Returns the source if you need to track it.
-		//This plays the sound explicitly from the given position, and is not attached to an entity.
-		std::shared_ptr<AudioSource> playGameSound(AlVec3f position, std::string fname, float gain = 1.f, float refDist = 20.f, float maxDist = 1200.f, bool loop = false)
+		//Pulls the position and velocity of every voice that follows an entity. Goes through the traits' batch query if it has one, so the
+		//game gets asked once for all of them, otherwise asks about each entity on its own.
+		void m_updateEntities()
 		{
-			AlVec3f srcPos = position;
-			ALfloat lPos[3] = { 0.f, 0.f, 0.f };
-			alGetListener3f(AL_POSITION, &lPos[0], &lPos[1], &lPos[2]);
-			AlVec3f listener(lPos[0], lPos[1], -lPos[2]);
-
-			if (m_useMaximumDistance) {
-				if (std::abs((srcPos - listener).length()) >= m_maximumDistance) {
-					return std::shared_ptr<AudioSource>(); //returns a null if the sound is more than a kilometer away
+			VoiceTable<T>& v = curGameSounds;
+			if (m_canBatchEntities()) {
+				m_batchIndex.clear();
+				m_batchEntities.clear();
+				for (uint32_t i = 0; i < v.size(); ++i) {
+					if (!(v.flags[i] & VoiceTable<T>::TRACKS_ENTITY)) continue;
+					m_batchIndex.push_back(i);
+					m_batchEntities.push_back(v.entity[i]);
 				}
+				if (m_queryEntities()) return;
+				for (uint32_t i : m_batchIndex) m_updateEntity(i); //the query declined after all
+				return;
 			}
-
-			ALuint buf = 0;
-			if (loadedGameSounds.find(fname) != loadedGameSounds.end()) {
-				buf = loadedGameSounds.at(fname);
+			for (uint32_t i = 0; i < v.size(); ++i) {
+				if (v.flags[i] & VoiceTable<T>::TRACKS_ENTITY) m_updateEntity(i);
 			}
-			else {
-				buf = gameSounds.loadAudio(m_gameSoundPath + fname);
-				if (buf == 0) return nullptr;
-				loadedGameSounds[fname] = buf;
+		}
+		//Whether the traits have a batch query that's going to answer, so it's worth gathering the entities up for it.
+		bool m_canBatchEntities() const
+		{
+			if constexpr (!HasEntityBatchQuery<EntityTraits, T>::value) return false;
+			else if constexpr (HasEntityQueryCheck<EntityTraits>::value) return m_traits.hasQuery();
+			else return true;
+		}
+		//Runs the traits' batch query over the gathered entities. Returns false if it didn't answer.
+		bool m_queryEntities()
+		{
+			if constexpr (HasEntityBatchQuery<EntityTraits, T>::value) {
+				VoiceTable<T>& v = curGameSounds;
+				size_t count = m_batchIndex.size();
+				if (count == 0) return true;
+				m_batchData.resize(count * 6);
+				m_batchValid.assign(count, 0);
+				EntityBatch<T> batch;
+				batch.entities = m_batchEntities.data();
+				batch.count = count;
+				batch.posX = m_batchData.data();
+				batch.posY = batch.posX + count;
+				batch.posZ = batch.posY + count;
+				batch.velX = batch.posZ + count;
+				batch.velY = batch.velX + count;
+				batch.velZ = batch.velY + count;
+				batch.valid = m_batchValid.data();
+				if (!m_traits.query(batch)) return false;
+				for (size_t b = 0; b < count; ++b) {
+					uint32_t i = m_batchIndex[b];
+					if (!batch.valid[b]) {
+						m_entityGone(i);
+						continue;
+					}
+					v.posX[i] = batch.posX[b]; v.posY[i] = batch.posY[b]; v.posZ[i] = batch.posZ[b];
+					v.velX[i] = batch.velX[b]; v.velY[i] = batch.velY[b]; v.velZ[i] = batch.velZ[b];
+				}
+				return true;
 			}
-			//also needs to register the audio source
-			AudioSource* src = new AudioSource;
-
-			src->setRefDist(refDist);
-			src->setMaxDist(maxDist);
-			src->setGain(gain * gameGain);
-			src->setLoop(loop);
-
-			src->setPitch(m_randomPitchOnGameSounds ? std::uniform_real_distribution<float>(.75f, 1.25f)(randGen) : 1.f);
-
-			src->play(buf);
-			_SoundInstance inst;
-			inst.src = std::shared_ptr<AudioSource>(src);
-			inst.overrideValidLoop = loop;
-
-			curGameSounds.push_back(inst);
-			return inst.src;
+			else return false;
 		}
-
-		//Plays a menu sound effect.
-		void playMenuSound(std::string fname)
+		//Asks the traits about a single voice's entity.
+		void m_updateEntity(uint32_t i)
+		{
+			VoiceTable<T>& v = curGameSounds;
+			if (m_traits.valid(v.entity[i])) { //if the entity is still alive we need to update the sound accordingly
+				v.setPos(i, m_traits.position(v.entity[i]));
+				v.setVel(i, m_traits.velocity(v.entity[i]));
+			}
+			else m_entityGone(i);
+		}
+		//Called when a voice's entity isn't alive anymore.
+		void m_entityGone(uint32_t i)
+		{
+			VoiceTable<T>& v = curGameSounds;
+			//we need to waste anything that's looping still, but if it's a regular effect just let it play out
+			if ((v.flags[i] & VoiceTable<T>::LOOP) && !(v.flags[i] & VoiceTable<T>::OVERRIDE_VALID_LOOP)) {
+				v.flags[i] &= ~VoiceTable<T>::LOOP;
+				if (v.src[i]) v.src[i]->setLoop(false); //this will make it finished on the next iteration
+			}
+		}
+		//Runs one update of the menu sounds. See menuSoundUpdate.
+		void m_menuUpdate()
+		{
+			m_pumpLoads(menuSounds, m_menuSoundTable, m_loadingMenuSounds, m_menuLoadLog);
+			if (!m_deferredMenuSounds.empty()) m_playDeferredMenu();
+			m_updateSourceStates();
+			size_t i = 0;
+			while (i < curMenuSounds.size()) {
+				AudioSource* src = curMenuSounds[i];
+				if (src->hasStopped()) {
+					menuSounds.release(src->getBuffer());
+					m_sourcePool.release(src);
+					curMenuSounds[i] = curMenuSounds.back();
+					curMenuSounds.pop_back();
+					continue;
+				}
+				++i;
+			}
+			m_ext.beginBatch();
+			m_flushListener();
+			m_ext.endBatch();
+		}
+		//Plays a menu sound. See playMenuSound.
+		//On the audio thread, a menu sound that isn't loaded yet gets loaded in the background and plays once it's ready, rather than
+		//holding up the update with a decode.
+		void m_playMenu(SoundId sound)
 		{
-			ALuint buf = 0;
-			if (loadedMenuSounds.find(fname) != loadedMenuSounds.end()) {
-				buf = loadedMenuSounds.at(fname);
+			if (sound.index >= m_menuSoundTable.size()) return;
+			_SoundEntry& entry = m_menuSoundTable[sound.index];
+			bool hit = entry.buf != 0;
+			if (!hit && !entry.loading) {
+				if (m_threaded) m_requestLoad(menuSounds, m_menuSoundTable, m_loadingMenuSounds, sound);
+				else entry.buf = menuSounds.loadAudio(entry.path);
+			}
+			if (entry.loading) { //still coming in from a preload, or the load that just got started
+				m_deferredMenuSounds.push_back(sound.index);
+				return;
 			}
-			else {
-				buf = menuSounds.loadAudio(m_menuSoundPath + fname);
-				if (buf == 0) return;
-				loadedMenuSounds[fname] = buf;
+			if (entry.buf == 0) return;
+			m_startMenu(entry, hit);
+		}
+		//Plays any menu sounds that were waiting on their load.
+		void m_playDeferredMenu()
+		{
+			size_t i = 0;
+			while (i < m_deferredMenuSounds.size()) {
+				_SoundEntry& entry = m_menuSoundTable[m_deferredMenuSounds[i]];
+				if (entry.loading) {
+					++i;
+					continue;
+				}
+				if (entry.buf != 0) m_startMenu(entry, false);
+				m_deferredMenuSounds[i] = m_deferredMenuSounds.back();
+				m_deferredMenuSounds.pop_back();
 			}
-			AudioSource* src = new AudioSource;
+		}
+		//Puts a loaded menu sound on a source.
+		void m_startMenu(_SoundEntry& entry, bool hit)
+		{
+			AudioSource* src = m_sourcePool.acquire();
+			if (!src) return;
+			menuSounds.acquire(entry.buf, hit);
 			src->setGain(menuGain);
-			src->play(buf);
+			m_make2D(src);
+			src->play(entry.buf);
 			curMenuSounds.push_back(src);
 		}
-		//Plays music. Will halt any present music.
-		void playMusic(std::string fname)
+		//Everything that can be asked of the driver in a frame, packed small enough to go through the audio thread's queue.
+		//Without the audio thread, commands just get run on the spot.
+		struct _Command {
+			enum Type : uint8_t {
+				PLAY_ENTITY,
+				PLAY_POSITION,
+				PLAY_MENU,
+				STOP_VOICE,
+				SET_VOICE_GAIN,
+				SET_VOICE_PITCH,
+				SET_VOICE_LOOP,
+				SET_VOICE_POSITION,
+				SET_LISTENER,
+				SET_GAINS
+			};
+			Type type = PLAY_POSITION;
+			uint8_t flags = 0;
+			VoiceHandle voice;
+			uint32_t sound = SoundId::INVALID;
+			T entity = T();
+			AlVec3f pos;
+			AlVec3f vel;
+			AlVec3f up;
+			AlVec3f forward;
+			float values[4] = { 0.f, 0.f, 0.f, 0.f };
+		};
+		//Runs the command now, or queues it for the audio thread. Returns false if the queue was full and the command got dropped.
+		bool m_submit(const _Command& cmd)
+		{
+			if (!m_threaded) {
+				m_execute(cmd);
+				return true;
+			}
+			if (m_commands->push(cmd)) return true;
+			++m_droppedCommands;
+			return false;
+		}
+		//Gives a play command a handle and submits it. The handle is handed out here on the calling thread, so it can be returned right
+		//away even though the sound itself only starts once the audio thread gets to it.
+		VoiceHandle m_submitPlay(_Command& cmd)
+		{
+			if (m_threaded) m_collectHandles();
+			cmd.voice = m_handles.allocate();
+			if (!m_submit(cmd)) {
+				VoiceHandle next = cmd.voice;
+				++next.generation;
+				m_handles.release(next);
+				return VoiceHandle();
+			}
+			if (m_threaded) return cmd.voice;
+			m_reclaimHandles();
+			return m_handles.isLive(cmd.voice) ? cmd.voice : VoiceHandle();
+		}
+		void m_execute(const _Command& cmd)
 		{
-			if (currentMusic != 0) {
-				musicSource->stop();
-				menuSounds.removeAudio(currentMusic);
+			VoiceTable<T>& v = curGameSounds;
+			uint32_t i = VoiceTable<T>::INVALID;
+			switch (cmd.type) {
+			case _Command::PLAY_ENTITY:
+				m_play(cmd.voice, SoundId{ cmd.sound }, cmd.entity, cmd.flags, m_traits.position(cmd.entity), m_traits.velocity(cmd.entity),
+					cmd.values[0], cmd.values[1], cmd.values[2]);
+				return;
+			case _Command::PLAY_POSITION:
+				m_play(cmd.voice, SoundId{ cmd.sound }, cmd.entity, cmd.flags, cmd.pos, AlVec3f(0, 0, 0), cmd.values[0], cmd.values[1], cmd.values[2]);
+				return;
+			case _Command::PLAY_MENU:
+				m_playMenu(SoundId{ cmd.sound });
+				return;
+			case _Command::SET_LISTENER:
+				m_setListener(cmd.pos, cmd.up, cmd.forward, cmd.vel);
+				return;
+			case _Command::SET_GAINS:
+				m_setGains(cmd.values[0], cmd.values[1], cmd.values[2], cmd.values[3]);
+				return;
+			default:
+				break;
 			}
 
-			auto music = menuSounds.loadAudio(m_musicPath + fname);
-			currentMusic = music;
-			musicSource->play(music);
+			//everything else works on a voice that might be long gone
+			i = v.find(cmd.voice);
+			if (i == VoiceTable<T>::INVALID) return;
+			AudioSource* src = v.src[i];
+			switch (cmd.type) {
+			case _Command::STOP_VOICE:
+				m_removeVoice(i);
+				return;
+			case _Command::SET_VOICE_GAIN:
+				v.gain[i] = cmd.values[0];
+				if (src) src->setGain(cmd.values[0] * gameGain);
+				break;
+			case _Command::SET_VOICE_PITCH:
+				v.pitch[i] = cmd.values[0];
+				if (src) src->setPitch(cmd.values[0]);
+				break;
+			case _Command::SET_VOICE_LOOP:
+				if (cmd.flags & VoiceTable<T>::LOOP) v.flags[i] |= VoiceTable<T>::LOOP;
+				else v.flags[i] &= ~VoiceTable<T>::LOOP;
+				if (src) src->setLoop((cmd.flags & VoiceTable<T>::LOOP) != 0);
+				break;
+			case _Command::SET_VOICE_POSITION:
+				v.setPos(i, cmd.pos);
+				if (src) src->setPos(cmd.pos);
+				break;
+			default:
+				break;
+			}
+			if (src) src->flush();
 		}
-		//Updates all the sounds in the game to be deleted and shuffled around.
-		//ALWAYS CALL setListenerPosition PRIOR TO USING THIS UPDATE
-		void gameSoundUpdate() {
-			auto it = curGameSounds.begin();
-			while (it != curGameSounds.end()) {
-				if (it->src->isFinished()) { //if the sound is finished we're done here
-					//std::cout << "erasing sound\n";
-					delete it->src;
-					it = curGameSounds.erase(it);
-					continue;
+		//The audio thread. Runs the queued commands and both updates, then sleeps until the next update is due.
+		void m_threadMain(std::chrono::steady_clock::duration period)
+		{
+			auto next = std::chrono::steady_clock::now();
+			while (!m_stopThread) {
+				{
+					std::lock_guard<std::mutex> lock(m_stateMutex);
+					_Command cmd;
+					while (m_commands->pop(cmd)) m_execute(cmd);
+					m_gameUpdate();
+					m_menuUpdate();
+					m_returnHandles();
 				}
-				if (m_validityFunc(it->id)) { //if the entity is still alive we need to update the sound accordingly
+				next += period;
+				auto now = std::chrono::steady_clock::now();
+				if (next < now) next = now; //fell behind, so don't try to catch up with a burst of updates
+				std::this_thread::sleep_until(next);
+			}
+		}
+		//Hands the slots of finished voices straight back to the handle allocator. Only for the game thread.
+		void m_reclaimHandles()
+		{
+			VoiceHandle next;
+			while (curGameSounds.popReleased(next)) m_handles.release(next);
+		}
+		//Sends the slots of finished voices back to the game thread. Only for the audio thread; anything that doesn't fit waits for next time.
+		void m_returnHandles()
+		{
+			VoiceHandle next;
+			while (!m_finishedHandles->full() && curGameSounds.popReleased(next)) m_finishedHandles->push(next);
+		}
+		//Picks up the slots the audio thread is done with.
+		void m_collectHandles()
+		{
+			VoiceHandle next;
+			while (m_finishedHandles->pop(next)) m_handles.release(next);
+		}
+		//Starts loading a registered sound in the background. If the load finishes on the spot (no worker pool, or it was already loaded)
+		//the entry gets its buffer straight away, otherwise it's marked as loading until collected.
+		static void m_requestLoad(AudioBuffer& bank, std::vector<_SoundEntry>& table, std::vector<uint32_t>& loading, SoundId sound)
+		{
+			_SoundEntry& entry = table[sound.index];
+			if (entry.buf != 0 || entry.loading) return;
 
-					it->src->setPos(m_positionFunc(it->id));
-					it->src->setVel(m_velocityFunc(it->id));
-				}
-				else { //if it's not alive, we need to waste anything that's looping still, but if it's a regular effect just let it play out
-					if (it->src->isLooping() && !it->src->overrideValidLoop) {
-						it->src->setLoop(false); //this will make it finished on the next iteration
+			entry.pending = bank.loadAudioAsync(entry.path);
+			if (m_isReady(entry.pending)) {
+				entry.buf = entry.pending.get();
+				entry.pending = std::shared_future<ALuint>();
+				return;
+			}
+			entry.loading = true;
+			loading.push_back(sound.index);
+		}
+		//Hands the buffers from any background loads that have finished to their sound table entries.
+		static void m_collectLoads(AudioBuffer& bank, std::vector<_SoundEntry>& table, std::vector<uint32_t>& loading)
+		{
+			for (size_t i = 0; i < loading.size();) {
+				_SoundEntry& entry = table[loading[i]];
+				if (!entry.loading || !m_isReady(entry.pending)) {
+					if (entry.loading) ++i;
+					else { //got cleaned up while it was loading
+						loading[i] = loading.back();
+						loading.pop_back();
 					}
+					continue;
 				}
-				++it;
+				ALuint buf = entry.pending.get();
+				entry.buf = (buf != 0 && bank.isResident(buf)) ? buf : 0; //a small budget can evict a load before it gets collected
+				entry.loading = false;
+				entry.pending = std::shared_future<ALuint>();
+				loading[i] = loading.back();
+				loading.pop_back();
 			}
 		}
-		//Wipes the data buffer for in-game sound effects. Useful for ending a scene and returning to menus.
-		void cleanupGameSounds()
+		//Collects finished game sound loads and hands each buffer straight to the voices that were waiting on it. They take their reference
+		//right away, since anything released later in the same update can evict a buffer nothing holds yet.
+		void m_collectGameLoads()
 		{
-			setListenerPosition(AlVec3f(0, 0, 0));
-			for (auto inst : curGameSounds) {
-				inst.src->stop();
-				delete inst.src;
+			m_collectLoads(gameSounds, m_gameSoundTable, m_loadingGameSounds);
+			VoiceTable<T>& v = curGameSounds;
+			for (uint32_t i = 0; i < v.size(); ++i) {
+				if (!(v.flags[i] & VoiceTable<T>::LOADING) || v.buf[i] != 0) continue;
+				const _SoundEntry& entry = m_gameSoundTable[v.sound[i]];
+				if (entry.loading || entry.buf == 0) continue;
+				v.buf[i] = entry.buf;
+				v.length[i] = gameSounds.getLength(entry.buf);
+				gameSounds.acquire(entry.buf, false);
 			}
-			curGameSounds.clear();
-
-			gameSounds.removeAllAudio();
-			loadedGameSounds.clear();
 		}
-		std::list<_SoundInstance> curGameSounds;
-		std::list<AudioSource*> curMenuSounds;
-
-		//Runs an update for menu sounds. Unlike the game sounds, this does not track entities or position.
-		//The "ingame" is meant to help for whether or not you're trying to play menu sounds while actively in game.
-		void menuSoundUpdate(bool inGame = false)
+		//Uploads whatever loads have finished for a bank and hands them to its sound table. While a preload is running, the timings get
+		//kept in the bank's log so the preload can pick out its own files.
+		void m_pumpLoads(AudioBuffer& bank, std::vector<_SoundEntry>& table, std::vector<uint32_t>& loading, _LoadLog& log)
 		{
-			auto it = curMenuSounds.begin();
-			while (it != curMenuSounds.end()) {
-				AudioSource* src = *it;
-				if (src->isFinished()) {
-					delete src;
-					it = curMenuSounds.erase(it);
+			if (bank.processLoads(log.preloads > 0 ? &log.timings : nullptr) == 0) return;
+			if (&bank == &gameSounds) m_collectGameLoads();
+			else m_collectLoads(bank, table, loading);
+		}
+		//Pumps the loads for a bulk preload until every one of them has finished. The state lock is only held while loads are being
+		//requested or handed to OpenAL, not while waiting on the workers. Whoever gets to a finished load first uploads it, so the audio
+		//thread never waits on a preload, and the preload takes the timings for its own files out of the log.
+		PreloadReport m_preload(AudioBuffer& bank, std::vector<_SoundEntry>& table, std::vector<uint32_t>& loading, _LoadLog& log,
+			std::vector<SoundId> sounds, size_t invalid, std::function<void(size_t, size_t)>& progress)
+		{
+			PreloadReport report;
+			auto start = std::chrono::steady_clock::now();
+			//the same file asked for twice only gets loaded and counted once
+			std::sort(sounds.begin(), sounds.end(), [](SoundId a, SoundId b) { return a.index < b.index; });
+			sounds.erase(std::unique(sounds.begin(), sounds.end()), sounds.end());
+			report.requested = sounds.size() + invalid;
+			report.failed = invalid;
+
+			std::unordered_set<std::string> paths;
+			auto countDone = [&]() {
+				size_t ready = 0;
+				for (SoundId sound : sounds) {
+					if (!table[sound.index].loading) ++ready;
+				}
+				return ready;
+			};
+			auto takeTimings = [&]() {
+				size_t kept = 0;
+				for (auto& timing : log.timings) {
+					if (paths.find(timing.fname) != paths.end()) report.files.push_back(std::move(timing));
+					else log.timings[kept++] = std::move(timing); //somebody else's, maybe another preload's
+				}
+				log.timings.resize(kept);
+			};
+			size_t done = 0;
+			{
+				std::lock_guard<std::mutex> lock(m_stateMutex);
+				++log.preloads;
+				for (SoundId sound : sounds) {
+					paths.insert(table[sound.index].path);
+					m_requestLoad(bank, table, loading, sound);
+				}
+				done = countDone();
+			}
+			if (progress) progress(done, sounds.size());
+			while (done < sounds.size()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				size_t ready = 0;
+				{
+					std::lock_guard<std::mutex> lock(m_stateMutex);
+					m_pumpLoads(bank, table, loading, log);
+					takeTimings();
+					ready = countDone();
 				}
-				if (it == curMenuSounds.end()) break;
+				if (ready != done) {
+					done = ready;
+					if (progress) progress(done, sounds.size());
+				}
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_stateMutex);
+				takeTimings();
+				if (--log.preloads == 0) log.timings.clear();
+				for (SoundId sound : sounds) {
+					if (table[sound.index].buf != 0) ++report.loaded;
+					else ++report.failed;
+				}
+			}
+			std::sort(report.files.begin(), report.files.end(),
+				[](const AudioBuffer::LoadTiming& a, const AudioBuffer::LoadTiming& b) { return a.decodeMs > b.decodeMs; });
+			report.totalMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+			return report;
+		}
+		//Sets a buffer's sample precision, if OpenAL can take it.
+		void m_setPrecision(AudioBuffer& bank, AudioBuffer::SamplePrecision precision)
+		{
+			if (precision == AudioBuffer::PRECISION_FLOAT32 && !m_ext.hasFloat32()) {
+				std::cerr << "AL_EXT_FLOAT32 isn't supported, sounds will stay 16-bit.\n";
+				precision = AudioBuffer::PRECISION_INT16;
+			}
+			bank.setPrecision(precision);
+		}
+		//Drops an evicted buffer from a sound table.
+		static void m_forgetBuffer(std::vector<_SoundEntry>& table, ALuint buf)
+		{
+			for (auto& entry : table) {
+				if (entry.buf == buf) entry.buf = 0;
+			}
+		}
+		static bool m_isReady(const std::shared_future<ALuint>& load)
+		{
+			return load.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+		//Estimates how loud a voice is at the listener, following the same AL_LINEAR_DISTANCE_CLAMPED model OpenAL is using.
+		float m_audibility(uint32_t i) const
+		{
+			float audibility;
+			uint8_t cull;
+			computeAudibilityScalar(m_emitters(i, 1), m_listener.position, gameGain, m_listener.maxDistSq, &audibility, &cull);
+			return audibility;
+		}
+		//Points the audibility kernel at a run of voices in the table.
+		EmitterArrays m_emitters(uint32_t start, size_t count) const
+		{
+			const VoiceTable<T>& v = curGameSounds;
+			EmitterArrays e;
+			e.posX = v.posX.data() + start;
+			e.posY = v.posY.data() + start;
+			e.posZ = v.posZ.data() + start;
+			e.gain = v.gain.data() + start;
+			e.refDist = v.refDist.data() + start;
+			e.maxDist = v.maxDist.data() + start;
+			e.count = count;
+			return e;
+		}
+		//Keeps the listener's squared maximum distance in line with the settings.
+		void m_updateMaxDistance() { m_listener.maxDistSq = m_useMaximumDistance ? m_maximumDistance * m_maximumDistance : 0.f; }
+		//Gives a virtual voice a real source and starts it at wherever its playback has gotten to.
+		bool m_promote(uint32_t i)
+		{
+			AudioSource* src = m_sourcePool.acquire();
+			if (!src) return false;
 
-				++it;
+			VoiceTable<T>& v = curGameSounds;
+			src->setPos(v.getPos(i));
+			src->setVel(v.getVel(i));
+			src->setRefDist(v.refDist[i]);
+			src->setMaxDist(v.maxDist[i]);
+			src->setGain(v.gain[i] * gameGain);
+			src->setLoop((v.flags[i] & VoiceTable<T>::LOOP) != 0);
+			src->setPitch(v.pitch[i]);
+			src->play(v.buf[i], v.playTime[i]);
+
+			v.src[i] = src;
+			v.realTime[i] = 0.f;
+			--m_voiceStats.virtualVoices;
+			++m_voiceStats.realVoices;
+			++m_voiceStats.promotions;
+			return true;
+		}
+		//Takes the source away from a voice, remembering where playback got to so it can pick back up later.
+		void m_demote(uint32_t i)
+		{
+			VoiceTable<T>& v = curGameSounds;
+			v.playTime[i] = v.src[i]->getOffset();
+			m_sourcePool.release(v.src[i]);
+			v.src[i] = nullptr;
+			--m_voiceStats.realVoices;
+			++m_voiceStats.virtualVoices;
+			++m_voiceStats.demotions;
+		}
+		//Sorts out which voices deserve a real source this frame. Anything that can't be heard at all gets demoted straight away. A real voice
+		//that drops out of the top voices only gives up its source to a virtual voice that's clearly louder than it, and only once it's held
+		//the source for a little while, so voices sitting right at the cutoff don't get stopped and restarted every other frame.
+		void m_updateVoiceRanking()
+		{
+			const VoiceTable<T>& v = curGameSounds;
+			size_t cutoff = std::min(m_maxRealVoices, m_rankedVoices.size());
+			auto louder = [&v](uint32_t a, uint32_t b) { return v.audibility[a] > v.audibility[b]; };
+			if (cutoff < m_rankedVoices.size()) {
+				std::nth_element(m_rankedVoices.begin(), m_rankedVoices.begin() + cutoff, m_rankedVoices.end(), louder);
 			}
-			if (!inGame) {
-				setListenerPosition(AlVec3f(0, 0, 0));
-				for (auto src : curMenuSounds) {
-					src->setPos(AlVec3f(0, 0, 0));
-					src->setVel(AlVec3f(0, 0, 0));
+			m_contenders.clear();
+			m_holdouts.clear();
+			for (size_t r = 0; r < m_rankedVoices.size(); ++r) {
+				uint32_t i = m_rankedVoices[r];
+				if (v.src[i] && v.audibility[i] <= 0.f) m_demote(i);
+				else if (v.src[i] && r >= cutoff) m_holdouts.push_back(i);
+				else if (!v.src[i] && r < cutoff && v.audibility[i] > 0.f) m_contenders.push_back(i);
+			}
+			std::sort(m_contenders.begin(), m_contenders.end(), louder);
+			std::sort(m_holdouts.begin(), m_holdouts.end(), [&v](uint32_t a, uint32_t b) { return v.audibility[a] < v.audibility[b]; });
+
+			//if the limit went down, the quietest voices past it have to go no matter what
+			size_t h = 0;
+			while (m_voiceStats.realVoices > m_maxRealVoices && h < m_holdouts.size()) m_demote(m_holdouts[h++]);
+			for (uint32_t i : m_contenders) {
+				if (m_voiceStats.realVoices >= m_maxRealVoices) {
+					//holdouts are quietest first and contenders loudest first, so one that can't be bumped now can't be bumped by anyone after
+					while (h < m_holdouts.size() && !m_canBump(m_holdouts[h], i)) ++h;
+					if (h == m_holdouts.size()) break;
+					m_demote(m_holdouts[h++]);
 				}
+				if (!m_promote(i)) break;
 			}
 		}
-		//Sets the listener position, including up values and forward velocity.
-		void setListenerPosition(AlVec3f pos, AlVec3f up = AlVec3f(0.f, 1.f, 0.f), AlVec3f forward = AlVec3f(0.f, 0.f, -1.f), AlVec3f vel = AlVec3f(0.f, 0.f, 0.f))
+		//Whether a real voice that's out of the top voices should hand its source over to the given virtual voice.
+		bool m_canBump(uint32_t real, uint32_t contender) const
 		{
-			auto err = alGetError();
-			ALfloat orient[] = { forward.x, forward.y, -forward.z, up.x, up.y, -up.z };
-			alListener3f(AL_POSITION, pos.x, pos.y, -pos.z);
-			alListener3f(AL_VELOCITY, vel.x, vel.y, -vel.z);
-			alListenerfv(AL_ORIENTATION, orient);
-			musicSource->setPos(pos);
-			musicSource->setVel(vel);
-			for (auto src : curMenuSounds) {
-				src->setPos(pos);
-				src->setVel(vel);
+			const VoiceTable<T>& v = curGameSounds;
+			return v.realTime[real] >= MIN_REAL_SECONDS && v.audibility[contender] > v.audibility[real] * PROMOTION_MARGIN;
+		}
+		//Hands a voice's source back to the pool, lets go of its buffer, and drops it from the table.
+		void m_removeVoice(uint32_t i)
+		{
+			VoiceTable<T>& v = curGameSounds;
+			if (v.src[i]) {
+				m_sourcePool.release(v.src[i]);
+				--m_voiceStats.realVoices;
 			}
+			else --m_voiceStats.virtualVoices;
+			if (v.buf[i] != 0) gameSounds.release(v.buf[i]); //a voice still marked as loading may already hold its buffer
+			v.erase(i);
 		}
-		//Sets the global gains for sound effects and the various types of sound.
-		void setGains(float master, float music, float game, float menu)
+		//Finds out which sources have stopped since the last update. With AL_SOFT_events this only looks at the sources OpenAL said stopped,
+		//so the cost goes with the number of sounds that finished rather than the number playing. Without it, a handful of sources get
+		//polled each update, round robin.
+		void m_updateSourceStates()
+		{
+			if (!m_ext.hasSourceEvents()) {
+				m_sourcePool.pollFinished(std::max(POLLED_SOURCES_PER_UPDATE, m_sourcePool.getStats().inUse / 4));
+				return;
+			}
+			if (m_ext.takeOverflow()) { //lost track of some events, so everything has to be checked once
+				m_sourcePool.pollFinished((size_t)-1);
+			}
+			ALuint id;
+			while (m_ext.popStoppedSource(id)) {
+				AudioSource* src = m_sourcePool.find(id);
+				if (src) src->pollFinished(); //the event might be from before the source got reused, so check it's still stopped
+			}
+		}
+		//Records where the listener is. It goes out to OpenAL on the next flush.
+		void m_setListener(const AlVec3f& pos, const AlVec3f& up, const AlVec3f& forward, const AlVec3f& vel)
+		{
+			m_listener.position = pos;
+			m_listener.velocity = vel;
+			m_listener.up = up;
+			m_listener.forward = forward;
+			m_listenerDirty = true;
+		}
+		void m_setGains(float master, float music, float game, float menu)
 		{
 			masterGain = master;
 			musicGain = music;
@@ -295,44 +1365,92 @@ class AudioDriver
 			menuGain = menu;
 			m_updateGains();
 		}
-
-		//Sets the paths to look for the various types of sound - music, menu, and gains. Default is no path.
-		void setPaths(std::string music, std::string menus, std::string game) { m_musicPath = music; m_menuSoundPath = menus; m_gameSoundPath = game; }
-		//If this is enabled, the game's sounds will vary in pitch by ~.5f to make them all sound less monotonous.
-		//Default: True
-		void setRandomPitch(bool random = true) { m_randomPitchOnGameSounds = random; }
-		//Sets the maximum distance a new sound can be spawned at. Default: 1500
-		//If the sound is further away from the listener than this distance, it will not play. Only works if useMaximumDistance is set to true.
-		void setMaximumDistance(float max) { m_maximumDistance = max; }
-		//Should this driver use a maximum distance to allow sounds to be played at? Default: True
-		void useMaximumDistance(bool maxDist = true) { m_useMaximumDistance = maxDist; }
-	private:
+		//Sends the listener to OpenAL if it's moved since the last flush. The music and menu sounds are relative to it, so they come along for free.
+		void m_flushListener()
+		{
+			if (!m_listenerDirty) return;
+			m_listenerDirty = false;
+			const AlVec3f& pos = m_listener.position;
+			const AlVec3f& vel = m_listener.velocity;
+			const AlVec3f& up = m_listener.up;
+			const AlVec3f& forward = m_listener.forward;
+			ALfloat orient[] = { forward.x, forward.y, -forward.z, up.x, up.y, -up.z };
+			alListener3f(AL_POSITION, pos.x, pos.y, -pos.z);
+			alListener3f(AL_VELOCITY, vel.x, vel.y, -vel.z);
+			alListenerfv(AL_ORIENTATION, orient);
+		}
+		//Pins a source to the listener: relative at the origin, and not spatialized at all if OpenAL lets us turn that off.
+		//The pool resets both when the source goes back, so game sounds never pick this up.
+		template<class S>
+		void m_make2D(S* src)
+		{
+			src->setRelative(true);
+			if (m_ext.hasSourceSpatialize()) src->setSpatialize(AL_FALSE);
+		}
 		void m_updateGains() {
 			auto err = alGetError();
 			alListenerf(AL_GAIN, masterGain);
 			musicSource->setGain(musicGain);
 			for (auto src : curMenuSounds) {
 				src->setGain(menuGain);
+				src->flush();
 			}
-			for (auto snd : curGameSounds) {
-				snd.src->setGain(gameGain);
+			for (uint32_t i = 0; i < curGameSounds.size(); ++i) {
+				if (curGameSounds.src[i]) {
+					curGameSounds.src[i]->setGain(curGameSounds.gain[i] * gameGain);
+					curGameSounds.src[i]->flush();
+				}
 			}
 		}
-		std::unordered_map<std::string, ALuint> loadedGameSounds;
-		std::unordered_map<std::string, ALuint> loadedMenuSounds;
+		std::unordered_map<uint64_t, SoundId> loadedGameSounds; //keyed by the name's hash, so a lookup never touches a string
+		std::unordered_map<uint64_t, SoundId> loadedMenuSounds;
+		std::vector<_SoundEntry> m_gameSoundTable; //indexed by SoundId
+		std::vector<_SoundEntry> m_menuSoundTable;
+		std::vector<uint32_t> m_loadingGameSounds; //sound table entries with a background load in flight
+		std::vector<uint32_t> m_loadingMenuSounds;
+		std::vector<uint32_t> m_deferredMenuSounds; //menu sounds that were played while they were still loading
+		_LoadLog m_gameLoadLog;
+		_LoadLog m_menuLoadLog;
 
 		std::string m_musicPath = "";
 		std::string m_menuSoundPath = "";
 		std::string m_gameSoundPath = "";
 
+		PcmCache m_pcmCache;
+		AudioWorkerPool m_workers;
 		AudioBuffer gameSounds;
 		AudioBuffer menuSounds;
-		ALuint currentMusic;
+		AudioSourcePool m_sourcePool;
+		LoadingPolicy m_loadingPolicy = LoadingPolicy::DEFER_START;
+		size_t m_maxRealVoices = 64;
+		VoiceStats m_voiceStats;
+		std::vector<uint32_t> m_rankedVoices; //indices into curGameSounds
+		std::vector<uint32_t> m_contenders; //virtual voices in the top voices, waiting on a source
+		std::vector<uint32_t> m_holdouts; //real voices that have dropped out of the top voices
+		std::vector<uint8_t> m_voiceCull; //EmitterCull flags from the last update, lined up with curGameSounds
+		std::vector<uint32_t> m_batchIndex; //voices that follow an entity, and the scratch arrays for asking about them in one go
+		std::vector<T> m_batchEntities;
+		std::vector<float> m_batchData;
+		std::vector<uint8_t> m_batchValid;
+		std::chrono::steady_clock::time_point m_lastGameUpdate = std::chrono::steady_clock::now();
+		AudioListener m_listener;
+		bool m_listenerDirty = true;
+		AudioExtensions m_ext;
 
-		AudioSource* musicSource; //should always be on top of the listener
+		//threaded mode
+		VoiceHandleAllocator m_handles; //only ever touched by the game thread
+		std::unique_ptr<SpscRing<_Command, COMMAND_QUEUE_SIZE>> m_commands; //game thread -> audio thread
+		std::unique_ptr<SpscRing<VoiceHandle, COMMAND_QUEUE_SIZE>> m_finishedHandles; //audio thread -> game thread
+		mutable std::mutex m_stateMutex; //held by the audio thread for each update, and by the game thread for anything that isn't a command
+		std::thread m_thread;
+		std::atomic<bool> m_stopThread{ false };
+		bool m_threaded = false;
+		uint64_t m_droppedCommands = 0;
+		AudioStream* musicSource; //relative to the listener, so it's always on top of it
 		//AudioSource* menuSource; //ditto - plays menu noises
 		ALCcontext* context;
 		ALCdevice* device;
+		int m_deviceRate = 0;
 		float masterGain = 1.f;
 		float musicGain = 1.f;
 		float gameGain = 1.f;
@@ -342,9 +1460,7 @@ class AudioDriver
 		std::random_device rd;
 		std::mt19937 randGen;
 
-		std::function<AlVec3f(T)> m_positionFunc;
-		std::function<AlVec3f(T)> m_velocityFunc;
-		std::function<bool(T)> m_validityFunc;
+		EntityTraits m_traits;
 
 		float m_maximumDistance = 1500.f;
 
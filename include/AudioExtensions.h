@@ -0,0 +1,150 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef AUDIOEXTENSIONS_H
+#define AUDIOEXTENSIONS_H
+#include "SpscRing.h"
+#include <al.h>
+#include <alc.h>
+#include <atomic>
+
+//The headers we ship with are plain OpenAL 1.1, so anything from the OpenAL Soft extensions has to be declared here.
+#ifndef AL_SOFT_deferred_updates
+#define AL_SOFT_deferred_updates 1
+#define AL_DEFERRED_UPDATES_SOFT 0xC002
+typedef void (AL_APIENTRY* LPALDEFERUPDATESSOFT)(void);
+typedef void (AL_APIENTRY* LPALPROCESSUPDATESSOFT)(void);
+#endif
+#ifndef AL_EXT_float32
+#define AL_EXT_float32 1
+#define AL_FORMAT_MONO_FLOAT32 0x10010
+#define AL_FORMAT_STEREO_FLOAT32 0x10011
+#endif
+#ifndef AL_EXT_STATIC_BUFFER
+#define AL_EXT_STATIC_BUFFER 1
+typedef ALvoid (AL_APIENTRY* PFNALBUFFERDATASTATICPROC)(const ALint buffer, ALenum format, ALvoid* data, ALsizei size, ALsizei freq);
+#endif
+#ifndef AL_SOFT_map_buffer
+#define AL_SOFT_map_buffer 1
+typedef unsigned int ALbitfieldSOFT;
+#define AL_MAP_READ_BIT_SOFT 0x00000001
+#define AL_MAP_WRITE_BIT_SOFT 0x00000002
+#define AL_MAP_PERSISTENT_BIT_SOFT 0x00000004
+#define AL_PRESERVE_DATA_BIT_SOFT 0x00000008
+typedef void (AL_APIENTRY* LPALBUFFERSTORAGESOFT)(ALuint buffer, ALenum format, const ALvoid* data, ALsizei size, ALsizei freq, ALbitfieldSOFT flags);
+typedef void* (AL_APIENTRY* LPALMAPBUFFERSOFT)(ALuint buffer, ALsizei offset, ALsizei length, ALbitfieldSOFT access);
+typedef void (AL_APIENTRY* LPALUNMAPBUFFERSOFT)(ALuint buffer);
+typedef void (AL_APIENTRY* LPALFLUSHMAPPEDBUFFERSOFT)(ALuint buffer, ALsizei offset, ALsizei length);
+#endif
+#ifndef AL_SOFT_source_spatialize
+#define AL_SOFT_source_spatialize 1
+#define AL_SOURCE_SPATIALIZE_SOFT 0x1214
+#define AL_AUTO_SOFT 0x0002
+#endif
+#ifndef AL_SOFT_events
+#define AL_SOFT_events 1
+#define AL_EVENT_CALLBACK_FUNCTION_SOFT 0x19A2
+#define AL_EVENT_CALLBACK_USER_PARAM_SOFT 0x19A3
+#define AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT 0x19A4
+#define AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT 0x19A5
+#define AL_EVENT_TYPE_DISCONNECTED_SOFT 0x19A6
+typedef void (AL_APIENTRY* ALEVENTPROCSOFT)(ALenum eventType, ALuint object, ALuint param, ALsizei length, const ALchar* message, void* userParam);
+typedef void (AL_APIENTRY* LPALEVENTCONTROLSOFT)(ALsizei count, const ALenum* types, ALboolean enable);
+typedef void (AL_APIENTRY* LPALEVENTCALLBACKSOFT)(ALEVENTPROCSOFT callback, void* userParam);
+#endif
+
+/*
+* Loads the optional OpenAL extensions the driver knows how to take advantage of, and wraps them so that the rest of the code doesn't have to
+* care whether they're there or not. Anything that isn't supported falls back to plain OpenAL 1.1 behavior.
+*/
+class AudioExtensions
+{
+	public:
+		~AudioExtensions();
+
+		//Checks which extensions the current context supports and loads their functions. Call this once the context is current.
+		void load(ALCcontext* context);
+
+		//Starts a batch of source and listener changes. None of the changes made until endBatch are heard until then, so the mixer never
+		//picks up half of a frame's worth of updates. Uses AL_SOFT_deferred_updates if it's there, or suspends the context if not.
+		void beginBatch();
+		//Applies every change made since beginBatch all at once.
+		void endBatch();
+
+		//Whether AL_SOFT_deferred_updates was found.
+		bool hasDeferredUpdates() const { return m_deferUpdates != nullptr; }
+
+		//Whether AL_SOFT_source_spatialize was found, meaning sources can be told not to be panned or attenuated at all.
+		bool hasSourceSpatialize() const { return m_sourceSpatialize; }
+
+		//Whether AL_EXT_FLOAT32 was found, meaning buffers can be given 32-bit float samples.
+		bool hasFloat32() const { return m_float32; }
+
+		//Whether AL_EXT_STATIC_BUFFER was found, meaning OpenAL can play straight out of memory we own instead of copying it.
+		bool hasStaticBuffers() const { return m_bufferDataStatic != nullptr; }
+		//Points a buffer at PCM we own. The memory has to stay put and untouched until the buffer is deleted. Only call this if
+		//hasStaticBuffers is true. Returns false if OpenAL didn't take it.
+		bool bufferDataStatic(ALuint buffer, ALenum format, void* data, ALsizei size, ALsizei rate) const;
+		//Whether AL_SOFT_map_buffer was found, meaning audio can be decoded straight into OpenAL's own copy of a buffer.
+		bool hasMapBuffer() const { return m_mapBuffer != nullptr; }
+		//Gives a buffer storage of the given size and maps all of it for reading and writing. Returns nullptr if OpenAL didn't go for it.
+		//The buffer can't be played until it's unmapped again.
+		void* mapNewBuffer(ALuint buffer, ALenum format, ALsizei size, ALsizei rate) const;
+		//Unmaps a buffer mapped by mapNewBuffer.
+		void unmapBuffer(ALuint buffer) const;
+
+		//Asks OpenAL to tell us whenever a source stops, instead of having to ask every source every frame. Returns false if AL_SOFT_events
+		//isn't available, in which case sources have to be polled.
+		bool startSourceEvents();
+		//Turns the source events back off.
+		void stopSourceEvents();
+		//Whether source events are coming in.
+		bool hasSourceEvents() const { return m_eventsStarted; }
+		//Takes the next source that OpenAL said has stopped. Returns false once there are none left.
+		bool popStoppedSource(ALuint& source) { return m_stoppedSources.pop(source); }
+		//Returns true (once) if events had to be dropped because the queue filled up, meaning every source needs to be checked by hand.
+		bool takeOverflow() { return m_overflow.exchange(false); }
+
+		//How many stopped sources can be waiting to be picked up before events start getting dropped.
+		static constexpr size_t EVENT_QUEUE_SIZE = 1024;
+	private:
+		//Gets called by OpenAL from its own event thread.
+		static void AL_APIENTRY m_eventCallback(ALenum eventType, ALuint object, ALuint param, ALsizei length, const ALchar* message, void* userParam);
+
+		ALCcontext* m_context = nullptr;
+		LPALDEFERUPDATESSOFT m_deferUpdates = nullptr;
+		LPALPROCESSUPDATESSOFT m_processUpdates = nullptr;
+		bool m_inBatch = false;
+		bool m_sourceSpatialize = false;
+		bool m_float32 = false;
+		PFNALBUFFERDATASTATICPROC m_bufferDataStatic = nullptr;
+		LPALBUFFERSTORAGESOFT m_bufferStorage = nullptr;
+		LPALMAPBUFFERSOFT m_mapBuffer = nullptr;
+		LPALUNMAPBUFFERSOFT m_unmapBuffer = nullptr;
+
+		LPALEVENTCONTROLSOFT m_eventControl = nullptr;
+		LPALEVENTCALLBACKSOFT m_eventCallbackFunc = nullptr;
+		bool m_eventsStarted = false;
+		SpscRing<ALuint, EVENT_QUEUE_SIZE> m_stoppedSources;
+		std::atomic<bool> m_overflow{ false };
+};
+
+#endif
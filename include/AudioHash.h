@@ -0,0 +1,51 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef AUDIOHASH_H
+#define AUDIOHASH_H
+#include <cstdint>
+#include <cstddef>
+
+//64-bit FNV-1a hash. Used for sound bank indices and cache keys. It's constexpr so it works on string literals at compile time too.
+constexpr uint64_t fnv1a64(const char* str, size_t len, uint64_t hash = 14695981039346656037ull)
+{
+	for (size_t i = 0; i < len; ++i) {
+		hash ^= (uint8_t)str[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//A sound name with its hash worked out ahead of time. Made with the _snd literal, so the hash happens at compile time and
+//playing the sound never builds a string or hashes anything.
+struct SoundName {
+	uint64_t key;
+	const char* str;
+	size_t len;
+};
+
+//Turns a string literal into a SoundName at compile time, e.g. "impact_1.ogg"_snd
+constexpr SoundName operator""_snd(const char* str, size_t len)
+{
+	return SoundName{ fnv1a64(str, len), str, len };
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef AUDIOLISTENER_H
+#define AUDIOLISTENER_H
+#include "AudioSource.h"
+#include <cmath>
+
+/*
+* The driver's copy of where the listener is. This is the one the driver trusts - OpenAL only ever gets told about it, never asked - so
+* culling and audibility never have to go back to OpenAL for it. Everything is in game coordinates, before the Z flip that happens when
+* it gets sent to OpenAL. The helpers are here so other systems (AI hearing, subtitles, UI indicators) can reason about sounds the same
+* way the driver does.
+*/
+struct AudioListener
+{
+	AlVec3f position;
+	AlVec3f velocity;
+	AlVec3f up = AlVec3f(0.f, 1.f, 0.f);
+	AlVec3f forward = AlVec3f(0.f, 0.f, -1.f);
+	//The square of the furthest a sound can be from the listener and still play. Zero means there's no limit.
+	float maxDistSq = 1500.f * 1500.f;
+
+	//Returns the squared distance from the listener to a point.
+	float distanceSq(const AlVec3f& point) const { return (point - position).lengthSq(); }
+	//Returns the distance from the listener to a point.
+	float distance(const AlVec3f& point) const { return std::sqrt(distanceSq(point)); }
+	//Returns whether a point is close enough to the listener for a sound there to play.
+	bool inRange(const AlVec3f& point) const { return maxDistSq <= 0.f || distanceSq(point) < maxDistSq; }
+	//Returns the unit vector pointing from the listener towards a point, or zero if the point is right on top of the listener.
+	AlVec3f direction(const AlVec3f& point) const
+	{
+		AlVec3f d = point - position;
+		float len = d.length();
+		if (len <= 0.f) return AlVec3f();
+		return AlVec3f(d.x / len, d.y / len, d.z / len);
+	}
+	//Returns the vector pointing to the right of the listener. Not normalized if forward and up aren't.
+	AlVec3f right() const
+	{
+		return AlVec3f(forward.y * up.z - forward.z * up.y, forward.z * up.x - forward.x * up.z, forward.x * up.y - forward.y * up.x);
+	}
+	//Puts a point into the listener's own frame: x is how far to the right, y how far up, and z how far in front.
+	//Assumes forward and up are unit length and at right angles to each other, like OpenAL does.
+	AlVec3f toListenerSpace(const AlVec3f& point) const
+	{
+		AlVec3f d = point - position;
+		AlVec3f r = right();
+		return AlVec3f(d.x * r.x + d.y * r.y + d.z * r.z, d.x * up.x + d.y * up.y + d.z * up.z, d.x * forward.x + d.y * forward.y + d.z * forward.z);
+	}
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef AUDIOMATH_H
+#define AUDIOMATH_H
+#include "AudioSource.h"
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Vectorized math over whole arrays of emitters or samples at once. The emitter kernels work on structure-of-arrays data (like VoiceTable)
+* so that 4 or 8 emitters fit in a register, and the sample kernels turn decoded audio into what gets handed to OpenAL. The best instruction
+* set the CPU supports gets picked the first time they're called: AVX2, then SSE2 on x86, NEON on 64-bit ARM, and plain C++ on anything else.
+*/
+
+//What the audibility kernel found out about an emitter, besides how loud it is.
+enum EmitterCull : uint8_t {
+	EMITTER_AUDIBLE = 0,
+	EMITTER_OUT_OF_RANGE = 1, //at or past its max distance, so the clamped linear model has it at zero gain
+	EMITTER_TOO_FAR = 2 //past the cull distance the kernel was given
+};
+
+//The arrays the audibility kernel reads. Every array is count long.
+struct EmitterArrays {
+	const float* posX = nullptr;
+	const float* posY = nullptr;
+	const float* posZ = nullptr;
+	const float* gain = nullptr;
+	const float* refDist = nullptr;
+	const float* maxDist = nullptr;
+	size_t count = 0;
+};
+
+//Works out how loud each emitter is at the listener under AL_LINEAR_DISTANCE_CLAMPED, scaled by gainScale, and flags the ones that can't be
+//heard. Anything flagged gets an audibility of zero. cullDistSq is the square of the cull distance; zero or less skips the distance cull.
+//distance can be nullptr if the distances themselves aren't needed.
+void computeAudibility(const EmitterArrays& emitters, const AlVec3f& listener, float gainScale, float cullDistSq,
+	float* audibility, uint8_t* cull, float* distance = nullptr);
+//Same as computeAudibility but always uses the plain C++ version. Mostly useful for checking the vectorized ones against.
+void computeAudibilityScalar(const EmitterArrays& emitters, const AlVec3f& listener, float gainScale, float cullDistSq,
+	float* audibility, uint8_t* cull, float* distance = nullptr);
+//Interleaves planar float channels (like ov_read_float hands back) into one buffer of frames. out needs room for frames * channels floats.
+void interleaveFloat(const float* const* planes, int channels, size_t frames, float* out);
+//Interleaves planar float channels and converts them to signed 16-bit samples the same way ov_read does: scaled by 32768, rounded, and
+//clipped. out needs room for frames * channels samples.
+void interleaveInt16(const float* const* planes, int channels, size_t frames, int16_t* out);
+//Mixes planar float channels down to one by averaging them, so a full-scale stereo sound can't clip. out needs room for frames floats.
+void downmixToMono(const float* const* planes, int channels, size_t frames, float* out);
+//Returns the name of the instruction set the kernels are using: "AVX2", "SSE2", "NEON", or "scalar". The emitter kernels are plain C++ on NEON.
+const char* audioMathPath();
+
+#endif
@@ -22,7 +22,9 @@
 #ifndef AUDIOSOURCE_H
 #define AUDIOSOURCE_H
 #include <al.h>
+#include "AudioExtensions.h"
 #include <cmath>
+#include <cstdint>
 
 #pragma comment(lib, "libogg.lib")
 #pragma comment(lib, "libvorbis_static.lib")
@@ -35,6 +37,7 @@ struct AlVec3f {
 	AlVec3f(float x, float y, float z) : x(x), y(y), z(z) {}
 	AlVec3f operator-(const AlVec3f& other) const { return AlVec3f(x - other.x, y - other.y, z - other.z); }
 	float length() const { return sqrt(x*x + y*y + z*z); }
+	float lengthSq() const { return x*x + y*y + z*z; }
 	float x = 0;
 	float y = 0;
 	float z = 0;
@@ -45,15 +48,23 @@ struct AlVec3f {
 * exactly a source is, go read up there, but for our purposes an audio source represents a single sound that is currently playing. Emphasis on SINGLE-
 * multiple sounds cannot play concurrently through one source. It includes several helpful functions to adjust values about the sound like
 * pitch, max distance, and whether or not it's looping.
+* The source keeps a copy of everything it has told OpenAL. The setters only mark a value as dirty when it actually changes, and nothing goes
+* out to OpenAL until flush (or play) is called, so setting the same value every frame costs nothing.
 */
 class AudioSource
 {
 	public:
+		//Counts of how many AL calls the setters actually made versus how many they got to skip because nothing changed.
+		struct CallStats {
+			uint64_t issued = 0;
+			uint64_t saved = 0;
+		};
+
 		AudioSource();
 		~AudioSource();
 
-		//Plays the sound from the buffer given.
-		void play(const ALuint bufToPlay);
+		//Plays the sound from the buffer given, starting the given number of seconds into it. Flushes any pending changes first.
+		void play(const ALuint bufToPlay, const float offset = 0.f);
 		//Stops the sound.
 		void stop();
 		//Sets the position of the source.
@@ -69,14 +80,64 @@ class AudioSource
 		//Returns whether or not the source is looping the current sound.
 		const bool isLooping();
 
+		//Sets whether the source's position is relative to the listener instead of the world. A relative source at the origin stays on top
+		//of the listener without ever needing to be moved. Default: False
+		void setRelative(const bool relative);
+		//Sets AL_SOURCE_SPATIALIZE_SOFT: AL_FALSE plays the sound flat with no panning or distance falloff, AL_TRUE always spatializes it,
+		//and AL_AUTO_SOFT leaves it up to OpenAL (mono sounds get spatialized). Only call this if AL_SOFT_source_spatialize is there.
+		//Default: AL_AUTO_SOFT
+		void setSpatialize(const ALint mode);
+
 		//Sets the maximum distance this sound can be heard from.
 		void setMaxDist(const float dist);
 		//Sets the distance for scaling on the sound.
 		void setRefDist(const float dist);
 
-		//Returns if the sound is finished or not.
+		//Returns the buffer the source is playing, or 0 if it isn't playing anything.
+		ALuint getBuffer() const { return buf; }
+		//Returns how many seconds into the current sound the source is.
+		float getOffset();
+
+		//Returns if the sound is finished or not. This asks OpenAL every time.
 		bool isFinished();
+		//Same as isFinished, but also remembers the answer for hasStopped.
+		bool pollFinished() { m_stopped = isFinished(); return m_stopped; }
+		//Returns whether the source was last seen to be stopped, without asking OpenAL. Only as fresh as the last pollFinished.
+		bool hasStopped() const { return buf == 0 || m_stopped; }
+		//Returns the OpenAL name of the source.
+		ALuint getId() const { return source; }
+		//Stops the sound and puts every value on the source back to its defaults, so it can be reused for a different sound.
+		void reset();
+		//Returns whether or not OpenAL actually managed to generate this source.
+		bool isValid() const { return m_valid; }
+		//Sends every value that's changed since the last flush to OpenAL.
+		void flush();
+
+		//Sets how much a float value (pitch, gain, position, etc) has to change by before it's worth sending to OpenAL. Default: 0, any change at all.
+		static void setEpsilon(const float epsilon) { s_epsilon = epsilon; }
+		//Returns the counts of AL calls issued and saved across every source.
+		static const CallStats& getCallStats() { return s_callStats; }
+		//Zeroes the AL call counters.
+		static void resetCallStats() { s_callStats = CallStats(); }
 	private:
+		enum DirtyBits : uint16_t {
+			DIRTY_PITCH = 1,
+			DIRTY_GAIN = 2,
+			DIRTY_POSITION = 4,
+			DIRTY_VELOCITY = 8,
+			DIRTY_LOOP = 16,
+			DIRTY_MAX_DIST = 32,
+			DIRTY_REF_DIST = 64,
+			DIRTY_RELATIVE = 128,
+			DIRTY_SPATIALIZE = 256
+		};
+		//Stores the new value and marks it dirty if it's different enough from the old one, otherwise counts the call as saved.
+		void m_set(float& current, const float value, const DirtyBits bit);
+		void m_set(float* current, const float* value, const DirtyBits bit);
+
+		//streams queue their own buffers on the source
+		friend class AudioStream;
+
 		float m_pitch = 1.f;
 		float m_gain = .7f;
 		float m_maxDist = 100.f;
@@ -85,9 +146,17 @@ class AudioSource
 		float m_velocity[3] = { 0,0,0 };
 		float m_direction[3] = { 0,0,0 };
 		bool m_loop = false;
-		ALuint source; //the identifier of the source, do not touch this
+		bool m_relative = false;
+		ALint m_spatialize = AL_AUTO_SOFT;
+		bool m_valid = false;
+		bool m_stopped = false;
+		uint16_t m_dirty = 0;
+		ALuint source = 0; //the identifier of the source, do not touch this
 		//a source has exactly ONE attached buffer - this means that a source plays ONE sound.
 		ALuint buf = 0;
+
+		static float s_epsilon;
+		static CallStats s_callStats;
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef AUDIOSOURCEPOOL_H
+#define AUDIOSOURCEPOOL_H
+#include "AudioSource.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+/*
+* The source pool holds a fixed set of audio sources that get generated once when the driver starts up. Generating and deleting a source
+* through OpenAL is a round trip every time, so instead sources get checked out of the pool when a sound plays and get reset and handed back
+* to the pool when the sound is done. Like audio buffers, this should never be seen outside of the AudioDriver class.
+*/
+class AudioSourcePool
+{
+public:
+	//Counters for how the pool is being used. Useful for figuring out if the pool is too small for a scene.
+	struct Stats {
+		//Number of acquires served straight from the free list.
+		uint64_t hits = 0;
+		//Number of acquires that had to generate a brand new source.
+		uint64_t misses = 0;
+		//Number of acquires that failed because the pool was at its maximum size with nothing free.
+		uint64_t exhausted = 0;
+		//Number of sources currently checked out.
+		size_t inUse = 0;
+		//The most sources that have been checked out at any one time.
+		size_t peakInUse = 0;
+		//Number of sources the pool currently owns.
+		size_t capacity = 0;
+	};
+
+	~AudioSourcePool();
+
+	//Generates the initial set of sources. The pool is allowed to generate more on demand up to maxSize.
+	//Returns the number of sources that were actually generated, which can be less than asked for if the hardware runs out.
+	size_t init(const size_t initialSize, const size_t maxSize);
+	//Checks a source out of the pool. Returns nullptr if the pool is exhausted.
+	AudioSource* acquire();
+	//Stops and resets the source, then hands it back to the pool.
+	void release(AudioSource* src);
+	//Deletes every source owned by the pool. Anything still checked out becomes invalid.
+	void clear();
+	//Returns the pooled source with the given OpenAL name, or nullptr if it isn't one of ours.
+	AudioSource* find(ALuint id) const;
+	//Checks up to the given number of sources to see if they've stopped, picking up where the last call left off. Spreads the cost of
+	//polling source states over several frames when OpenAL can't tell us when they stop.
+	void pollFinished(size_t count);
+
+	//Returns the usage counters for the pool.
+	const Stats& getStats() const { return m_stats; }
+private:
+	//Generates one more source for the pool. Returns nullptr if OpenAL refused.
+	AudioSource* m_generate();
+
+	std::vector<std::unique_ptr<AudioSource>> m_sources;
+	std::vector<AudioSource*> m_free;
+	std::unordered_map<ALuint, AudioSource*> m_byId;
+	size_t m_pollCursor = 0;
+	size_t m_maxSize = 0;
+	Stats m_stats;
+};
+
+#endif
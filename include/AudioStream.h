@@ -0,0 +1,98 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef AUDIOSTREAM_H
+#define AUDIOSTREAM_H
+#include "AudioSource.h"
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+
+struct OggVorbis_File;
+
+/*
+* An audio stream plays a long .ogg file (read: music) without decoding the whole thing up front. It keeps a small ring of buffers queued
+* on its source and a background thread decodes the next chunk of the file into each buffer as OpenAL finishes playing it, so memory stays
+* at a few hundred KB no matter how long the track is. Looping is handled by the decoder seeking back to the start of the file, so there's
+* no gap at the loop point.
+*/
+class AudioStream
+{
+	public:
+		AudioStream();
+		~AudioStream();
+
+		//Starts streaming the given file. Any stream that's already playing is stopped first.
+		//Returns false if the streaming thread couldn't be started; a file that fails to open is reported from the streaming thread.
+		bool play(const std::string& fname);
+		//Stops the stream and closes the file.
+		void stop();
+		//Sets the position of the stream's source.
+		void setPos(const AlVec3f pos) { m_source.setPos(pos); m_source.flush(); }
+		//Sets the velocity of the stream's source.
+		void setVel(const AlVec3f vel) { m_source.setVel(vel); m_source.flush(); }
+		//Sets the gain of the stream's source.
+		void setGain(const float gain) { m_source.setGain(gain); m_source.flush(); }
+		//Sets whether the stream's source is relative to the listener. See AudioSource::setRelative.
+		void setRelative(const bool relative) { m_source.setRelative(relative); m_source.flush(); }
+		//Sets whether the stream's source gets spatialized. See AudioSource::setSpatialize.
+		void setSpatialize(const ALint mode) { m_source.setSpatialize(mode); m_source.flush(); }
+		//Sets whether the stream starts over when it hits the end of the file. Default: True
+		void setLoop(const bool loop) { m_loop = loop; }
+		//Returns whether or not the stream is still running.
+		bool isPlaying() const { return m_running; }
+
+		//Number of buffers kept in the ring.
+		static constexpr int NUM_BUFFERS = 4;
+		//Size in bytes of each buffer in the ring.
+		static constexpr size_t BUFFER_SIZE = 65536;
+	private:
+		//The streaming thread - opens the file, keeps the ring topped up, and cleans up when it's told to stop or the file runs out.
+		void m_run(std::string fname);
+		//Decodes the next chunk of the file into the given buffer. Returns false if there was nothing left to decode.
+		bool m_fill(ALuint buffer);
+		//Opens the file for decoding.
+		bool m_open(const std::string& fname);
+		//Closes the file.
+		void m_close();
+
+		AudioSource m_source;
+		ALuint m_buffers[NUM_BUFFERS] = { 0 };
+		char m_pcm[BUFFER_SIZE];
+
+		FILE* m_fp = nullptr;
+		std::unique_ptr<OggVorbis_File> m_vf;
+		ALenum m_format = 0;
+		ALsizei m_rate = 0;
+
+		std::thread m_thread;
+		std::atomic<bool> m_running{ false };
+		std::atomic<bool> m_stopRequested{ false };
+		std::atomic<bool> m_loop{ true };
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+};
+
+#endif
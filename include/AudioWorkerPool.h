@@ -0,0 +1,57 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef AUDIOWORKERPOOL_H
+#define AUDIOWORKERPOOL_H
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+/*
+* The worker pool is a plain set of threads that chew through a queue of jobs. The driver uses it to decode audio files in the background
+* so that loading a sound doesn't hitch the game. Jobs that run on the pool should NEVER touch OpenAL - anything that needs the context
+* gets handed back to the thread that owns it.
+*/
+class AudioWorkerPool
+{
+	public:
+		//Starts up the given number of threads. 0 means one less than however many cores the machine has, with a minimum of one.
+		AudioWorkerPool(unsigned int threads = 0);
+		//Finishes whatever jobs are still queued, then shuts down the threads.
+		~AudioWorkerPool();
+
+		//Queues up a job to be run on one of the worker threads.
+		void submit(std::function<void()> job);
+		//Returns how many threads the pool is running.
+		unsigned int getThreadCount() const { return (unsigned int)m_threads.size(); }
+	private:
+		void m_work();
+
+		std::vector<std::thread> m_threads;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		bool m_stopping = false;
+};
+
+#endif
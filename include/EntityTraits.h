@@ -0,0 +1,116 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef ENTITYTRAITS_H
+#define ENTITYTRAITS_H
+#include "AudioSource.h"
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+
+/*
+* Entity traits tell the audio driver how to get the position, velocity, and validity (aliveness) of whatever your game uses as an entity.
+* A traits type just needs these three functions, static or not:
+*
+*	struct MyEntityTraits {
+*		static AlVec3f position(const MyEntity& ent) { return AlVec3f(ent.pos.X, ent.pos.Y, ent.pos.Z); }
+*		static AlVec3f velocity(const MyEntity& ent) { return AlVec3f(ent.vel.X, ent.vel.Y, ent.vel.Z); }
+*		static bool valid(const MyEntity& ent) { return ent.isAlive(); }
+*	};
+*	AudioDriver<MyEntity, MyEntityTraits> driver;
+*
+* Since the driver knows the traits type at compile time, these calls can get inlined straight into the update loop.
+*
+* With thousands of sounds on entities, a traits type can also answer for every tracked voice at once by adding a query function. The driver
+* then calls it once per update instead of calling the three functions above per voice, and the game can fill the arrays straight out of its
+* own component data however it likes (vectorized, on a job system, etc). It returns whether it filled the batch, so it can decline and let
+* the driver fall back to the per-entity functions:
+*
+*	bool query(EntityBatch<MyEntity>& batch) const {
+*		for (size_t i = 0; i < batch.count; ++i) { ... batch.posX[i] = ...; batch.valid[i] = 1; }
+*		return true;
+*	}
+*
+* If whether the query will answer is known before the batch gets built, a hasQuery function saves the driver gathering the entities up
+* for nothing:
+*
+*	bool hasQuery() const { return m_useBatches; }
+*
+* All of these get called in the middle of the driver's update, with the driver's state locked (on the audio thread, if it's running). They
+* must not call back into the driver: any call that locks the driver deadlocks, and one that doesn't can change the voices out from under
+* the update. Work out whatever the sounds need to do from their result and do it after gameSoundUpdate returns.
+*/
+
+//Everything a batch query needs to fill in. Every array is count long, and entry i of the outputs belongs to entities[i].
+template<class T>
+struct EntityBatch
+{
+	const T* entities = nullptr;
+	size_t count = 0;
+	float* posX = nullptr;
+	float* posY = nullptr;
+	float* posZ = nullptr;
+	float* velX = nullptr;
+	float* velY = nullptr;
+	float* velZ = nullptr;
+	uint8_t* valid = nullptr; //nonzero if the entity is still alive; position and velocity are ignored otherwise
+};
+
+//Whether a traits type has a batch query. Used by the driver to pick between the batch and per-entity paths at compile time.
+template<class Traits, class T, class = void>
+struct HasEntityBatchQuery : std::false_type {};
+template<class Traits, class T>
+struct HasEntityBatchQuery<Traits, T, std::void_t<decltype(std::declval<const Traits&>().query(std::declval<EntityBatch<T>&>()))>> : std::true_type {};
+//Whether a traits type can say ahead of time if its batch query will answer.
+template<class Traits, class = void>
+struct HasEntityQueryCheck : std::false_type {};
+template<class Traits>
+struct HasEntityQueryCheck<Traits, std::void_t<decltype(std::declval<const Traits&>().hasQuery())>> : std::true_type {};
+
+//The default traits, which wrap plain functions. This is what the driver uses when it's given the three functions in its constructor.
+template<class T>
+struct FunctionEntityTraits
+{
+	FunctionEntityTraits() {}
+	FunctionEntityTraits(std::function<AlVec3f(T)> velocityFunc, std::function<AlVec3f(T)> positionFunc, std::function<bool(T)> validityFunc)
+		: m_velocityFunc(velocityFunc), m_positionFunc(positionFunc), m_validityFunc(validityFunc) {}
+
+	AlVec3f position(const T& ent) const { return m_positionFunc(ent); }
+	AlVec3f velocity(const T& ent) const { return m_velocityFunc(ent); }
+	bool valid(const T& ent) const { return m_validityFunc(ent); }
+	//Whether a batch function was given.
+	bool hasQuery() const { return (bool)m_batchFunc; }
+	//Only answers if a batch function was given.
+	bool query(EntityBatch<T>& batch) const
+	{
+		if (!m_batchFunc) return false;
+		m_batchFunc(batch);
+		return true;
+	}
+
+	std::function<AlVec3f(T)> m_velocityFunc;
+	std::function<AlVec3f(T)> m_positionFunc;
+	std::function<bool(T)> m_validityFunc;
+	std::function<void(EntityBatch<T>&)> m_batchFunc;
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <string>
+#include <cstddef>
+/*
+* A read-only memory mapping of a file. The whole file shows up as one block of memory and the OS pages it in as it gets read, so there's
+* exactly one file open no matter how many sounds get pulled out of it.
+*/
+class MappedFile
+{
+	public:
+		MappedFile() {}
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		//Maps the given file into memory. Any file that was already mapped gets unmapped first.
+		bool open(const std::string& path);
+		//Unmaps the file.
+		void close();
+
+		//Returns the start of the mapped file, or nullptr if nothing is mapped.
+		const char* getData() const { return m_data; }
+		//Returns the size of the mapped file in bytes.
+		size_t getSize() const { return m_size; }
+		//Returns whether or not a file is currently mapped.
+		bool isOpen() const { return m_data != nullptr; }
+	private:
+		const char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef PCMCACHE_H
+#define PCMCACHE_H
+#include "MappedFile.h"
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+/*
+* The PCM cache keeps already-decoded audio on disk so that the next launch doesn't have to run the Vorbis decoder again. Each source file
+* gets one cache entry per way it was decoded (its variant) holding the raw PCM plus its format and rate, and the entry remembers the source's modification time, size and a hash
+* of its contents. If the source changes the entry is thrown out automatically. Cache hits are memory mapped and handed straight to OpenAL.
+*
+* The cache directory is kept under a byte budget by deleting the least recently used entries. This is safe to use from the worker pool.
+*/
+class PcmCache
+{
+	public:
+		//A cache hit. The PCM stays valid for as long as the mapping is held.
+		struct CachedPcm {
+			std::unique_ptr<MappedFile> file;
+			const char* data = nullptr;
+			size_t size = 0;
+			int32_t format = 0;
+			int32_t rate = 0;
+			int32_t channels = 0;
+		};
+		struct Stats {
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t stale = 0; //entries thrown out because the source file changed
+			uint64_t evictions = 0;
+			uint64_t bytes = 0; //current size of the cache directory
+		};
+
+		//Points the cache at a directory, creating it if needed. An empty directory turns the cache off.
+		bool setDirectory(const std::string& dir, uint64_t maxBytes);
+		//Returns whether or not the cache is turned on.
+		bool isEnabled() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return !m_dir.empty();
+		}
+		//Looks for a fresh cache entry for the given source file. The variant tells apart the same file decoded different ways, e.g. in
+		//another sample format or mixed down to mono; entries only match the variant they were stored with.
+		bool lookup(const std::string& sourcePath, CachedPcm& out, uint64_t variant = 0);
+		//Writes decoded PCM for the given source file into the cache, evicting old entries if the cache is over budget.
+		void store(const std::string& sourcePath, int32_t format, int32_t rate, int32_t channels, const char* pcm, size_t size, uint64_t variant = 0);
+		//Returns the cache counters.
+		Stats getStats();
+
+		static constexpr uint32_t VERSION = 1;
+	private:
+		struct Header {
+			char magic[4];
+			uint32_t version;
+			uint64_t sourceTime;
+			uint64_t sourceSize;
+			uint64_t contentHash;
+			int32_t format;
+			int32_t rate;
+			int32_t channels;
+			uint32_t reserved;
+			uint64_t dataSize;
+		};
+		//Returns the path of the cache entry for a source file and variant in the given cache directory.
+		static std::string m_entryPath(const std::string& dir, const std::string& sourcePath, uint64_t variant);
+		//Hashes the contents of the source file. Returns false if it can't be read.
+		static bool m_hashFile(const std::string& path, uint64_t& hash);
+		//Deletes least recently used entries until the cache fits in its budget.
+		void m_evict();
+
+		std::string m_dir;
+		uint64_t m_maxBytes = 0;
+		Stats m_stats;
+		mutable std::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,71 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef POLYPHASERESAMPLER_H
+#define POLYPHASERESAMPLER_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Converts planar float audio from one sample rate to another, a chunk at a time. The ratio between the rates is reduced to L/M, and a
+* Kaiser-windowed sinc filter is split into L phases so each output sample only costs one short dot product per channel. This is meant to
+* run once when a sound loads, so it uses a much longer filter than a mixer could afford to run per voice per frame.
+*
+* Output sample n lines up exactly with input time n * M / L, so there's no delay to account for. Call flush at the end of the input to get
+* the last few output samples out.
+*/
+class PolyphaseResampler
+{
+	public:
+		//Sets up the resampler. Returns false if the rates are the same, aren't valid, or don't reduce to a small enough ratio to make a
+		//filter bank for, in which case the audio should be left as it is.
+		//halfTaps is how many input samples the filter looks at on each side of an output sample.
+		bool init(int channels, int inRate, int outRate, int halfTaps = 16);
+		//Feeds frames of planar input and returns how many frames of output that made. The output stays in output() until the next call.
+		size_t process(const float* const* planes, size_t frames);
+		//Runs the end of the input through the filter. Returns how many frames of output that made, in output().
+		size_t flush();
+		//The output planes from the last process or flush.
+		const float* const* output() const { return m_outPlanes.data(); }
+
+		//Returns how many frames of output the given number of input frames turns into.
+		size_t outputFrames(size_t inputFrames) const { return (size_t)(((uint64_t)inputFrames * m_up + m_down - 1) / m_down); }
+
+		//Ratios that reduce to more phases than this don't get a filter bank.
+		static constexpr int MAX_PHASES = 1024;
+	private:
+		//Makes as much output as the buffered input allows.
+		size_t m_run();
+
+		int m_channels = 0;
+		int m_halfTaps = 0;
+		uint32_t m_up = 1; //L
+		uint32_t m_down = 1; //M
+		std::vector<float> m_coeffs; //m_up phases of 2 * m_halfTaps taps each
+		std::vector<std::vector<float>> m_history; //per channel, buffered input starting at input frame m_base
+		int64_t m_base = 0;
+		uint64_t m_nextOut = 0;
+		std::vector<std::vector<float>> m_out;
+		std::vector<const float*> m_outPlanes;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef SOUNDBANK_H
+#define SOUNDBANK_H
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+/*
+* A sound bank is a single file holding a pile of .ogg files back to back, with an index up front sorted by a hash of each sound's name.
+* Banks are memory mapped, so looking a sound up is a binary search over the index and the .ogg data gets decoded straight out of the
+* mapping without opening any more files.
+*
+* Layout (all values little-endian):
+*	Header		magic "BSBK", version, entry count, reserved
+*	Entries		one per sound, sorted by name hash
+*	Names		the name of each sound, not null-terminated
+*	Data		the .ogg files themselves
+*
+* Banks get built from a directory of .ogg files with the SoundBankPacker tool.
+*/
+class SoundBank
+{
+	public:
+		struct Header {
+			char magic[4];
+			uint32_t version;
+			uint32_t count;
+			uint32_t reserved;
+		};
+		struct Entry {
+			uint64_t nameHash;
+			uint32_t nameOffset; //from the start of the file
+			uint32_t nameLength;
+			uint64_t dataOffset; //from the start of the file
+			uint64_t dataSize;
+		};
+		static constexpr uint32_t VERSION = 1;
+
+		//Maps the bank and checks that its index is sane.
+		bool open(const std::string& path);
+		//Unmaps the bank.
+		void close();
+		//Looks up a sound by name. Returns true and points data at the .ogg file inside the bank if it's in here.
+		bool find(const std::string& name, const char*& data, size_t& size) const;
+		//Returns how many sounds are in the bank.
+		size_t getCount() const { return m_count; }
+		//Returns the path the bank was opened from.
+		const std::string& getPath() const { return m_path; }
+
+		//Writes out a bank containing the given files. names[i] is the name the file at paths[i] will be looked up by.
+		static bool pack(const std::string& outPath, const std::vector<std::string>& names, const std::vector<std::string>& paths);
+		//The 64-bit FNV-1a hash used for the index.
+		static uint64_t hashName(const char* str, size_t len);
+	private:
+		Entry m_entry(size_t i) const;
+
+		MappedFile m_file;
+		std::string m_path;
+		size_t m_count = 0;
+};
+
+#endif
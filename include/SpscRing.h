@@ -0,0 +1,66 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef SPSCRING_H
+#define SPSCRING_H
+#include <atomic>
+#include <cstddef>
+
+/*
+* A fixed size, lock-free queue for handing small values from exactly one producer thread to exactly one consumer thread. Neither side ever
+* blocks or allocates - push fails if the ring is full and pop fails if it's empty - so it's safe to use from inside OpenAL's callbacks.
+* N has to be a power of two.
+*/
+template<class T, size_t N>
+class SpscRing
+{
+	static_assert(N > 1 && (N & (N - 1)) == 0, "SpscRing size has to be a power of two");
+	public:
+		//Adds a value to the ring. Only call this from the producer thread. Returns false if the ring is full.
+		bool push(const T& value)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head - m_tail.load(std::memory_order_acquire) >= N) return false;
+			m_items[head & (N - 1)] = value;
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+		//Takes the oldest value out of the ring. Only call this from the consumer thread. Returns false if the ring is empty.
+		bool pop(T& value)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail == m_head.load(std::memory_order_acquire)) return false;
+			value = m_items[tail & (N - 1)];
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+		//Returns whether the ring is full. Only reliable from the producer thread.
+		bool full() const { return m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire) >= N; }
+		//Returns whether the ring looks empty. Only a hint if the producer is still pushing.
+		bool empty() const { return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire); }
+	private:
+		//head and tail get their own cache lines so the two threads aren't fighting over one
+		alignas(64) std::atomic<size_t> m_head{ 0 };
+		alignas(64) std::atomic<size_t> m_tail{ 0 };
+		T m_items[N];
+};
+
+#endif
@@ -0,0 +1,263 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+#pragma once
+#ifndef VOICETABLE_H
+#define VOICETABLE_H
+#include "AudioSource.h"
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+//Refers to a playing game sound for as long as it lives - a slot index plus a generation. Once the sound finishes or gets stopped the handle
+//goes stale, and anything done with it becomes a no-op, even if the slot has been reused by a newer sound. Cheap to copy and store.
+struct VoiceHandle {
+	uint32_t index = 0xFFFFFFFF;
+	uint32_t generation = 0;
+	//Whether the handle was ever given out for a sound. A valid handle can still be stale.
+	bool isValid() const { return index != 0xFFFFFFFF; }
+	bool operator==(const VoiceHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const VoiceHandle& other) const { return !(*this == other); }
+};
+static_assert(std::is_trivially_copyable<VoiceHandle>::value, "VoiceHandle has to stay trivially copyable");
+
+/*
+* Hands out voice handles. This is kept apart from the voice table so that handles can be given out on the game thread while the table itself
+* lives on the audio thread; slots only come back here once the table is done with them.
+*/
+class VoiceHandleAllocator
+{
+	public:
+		//Returns a handle for a slot that isn't in use.
+		VoiceHandle allocate()
+		{
+			VoiceHandle handle;
+			if (!m_free.empty()) {
+				handle.index = m_free.back();
+				m_free.pop_back();
+			}
+			else {
+				handle.index = (uint32_t)m_generation.size();
+				m_generation.push_back(1);
+				m_live.push_back(false);
+			}
+			m_live[handle.index] = true;
+			handle.generation = m_generation[handle.index];
+			return handle;
+		}
+		//Takes a slot back from the voice table, along with the generation it moved on to.
+		void release(VoiceHandle next)
+		{
+			if (next.index >= m_generation.size() || !m_live[next.index]) return;
+			m_generation[next.index] = next.generation;
+			m_live[next.index] = false;
+			m_free.push_back(next.index);
+		}
+		//Returns whether the handle is still out there. Only as fresh as the last release.
+		bool isLive(VoiceHandle handle) const
+		{
+			return handle.index < m_generation.size() && m_live[handle.index] && m_generation[handle.index] == handle.generation;
+		}
+	private:
+		std::vector<uint32_t> m_generation;
+		std::vector<bool> m_live;
+		std::vector<uint32_t> m_free;
+};
+
+/*
+* The voice table holds every game sound that's currently playing. Each field lives in its own contiguous array (structure of arrays)
+* so that the per-frame update is a straight sweep through memory instead of chasing list nodes around the heap. Voices are packed densely
+* at indices [0, size()), and removing one moves the last voice into its spot. Since that shuffles indices around, anything that needs to
+* hold onto a voice across frames keeps a VoiceHandle instead - a slot index plus a generation that goes stale once the voice is removed.
+* Handles come from a VoiceHandleAllocator, and the table queues up every slot it's done with so that they can be handed back to it.
+* Like the source pool, this should never be seen outside of the AudioDriver class.
+*/
+template<class T>
+class VoiceTable
+{
+	public:
+		static constexpr uint32_t INVALID = 0xFFFFFFFF;
+		//Bits for the flags array.
+		enum Flags : uint8_t {
+			LOOP = 1,
+			TRACKS_ENTITY = 2, //follows an entity around and stops looping when the entity dies
+			OVERRIDE_VALID_LOOP = 4, //keeps looping no matter what the entity is doing
+			LOADING = 8 //waiting on the buffer to finish loading in the background
+		};
+
+		//Adds a voice with all its fields defaulted under the given handle. The new voice is always the last one, at index size() - 1.
+		void insert(VoiceHandle handle)
+		{
+			uint32_t slot = handle.index;
+			m_growSlots(slot);
+			m_generation[slot] = handle.generation;
+			uint32_t i = (uint32_t)entity.size();
+			m_slotToDense[slot] = i;
+			m_denseToSlot.push_back(slot);
+
+			entity.emplace_back();
+			posX.push_back(0.f); posY.push_back(0.f); posZ.push_back(0.f);
+			velX.push_back(0.f); velY.push_back(0.f); velZ.push_back(0.f);
+			gain.push_back(1.f);
+			pitch.push_back(1.f);
+			refDist.push_back(20.f);
+			maxDist.push_back(1200.f);
+			length.push_back(0.f);
+			playTime.push_back(0.f);
+			realTime.push_back(0.f);
+			audibility.push_back(0.f);
+			buf.push_back(0);
+			sound.push_back(INVALID);
+			flags.push_back(0);
+			src.push_back(nullptr);
+		}
+		//Gives up on a handle that never got a voice inserted under it, so that its slot still makes it back to the allocator.
+		void discard(VoiceHandle handle)
+		{
+			m_growSlots(handle.index);
+			m_generation[handle.index] = handle.generation + 1;
+			m_release(handle.index);
+		}
+		//Removes the voice at the given index by moving the last voice into its place. Any handle to the removed voice goes stale.
+		//The voice's source (if any) has to have been handed back to the pool already.
+		void erase(uint32_t i)
+		{
+			uint32_t slot = m_denseToSlot[i];
+			++m_generation[slot];
+			m_slotToDense[slot] = INVALID;
+			m_release(slot);
+
+			uint32_t last = (uint32_t)entity.size() - 1;
+			if (i != last) m_slotToDense[m_denseToSlot[last]] = i;
+			m_moveBack(m_denseToSlot, i);
+			m_moveBack(entity, i);
+			m_moveBack(posX, i); m_moveBack(posY, i); m_moveBack(posZ, i);
+			m_moveBack(velX, i); m_moveBack(velY, i); m_moveBack(velZ, i);
+			m_moveBack(gain, i);
+			m_moveBack(pitch, i);
+			m_moveBack(refDist, i);
+			m_moveBack(maxDist, i);
+			m_moveBack(length, i);
+			m_moveBack(playTime, i);
+			m_moveBack(realTime, i);
+			m_moveBack(audibility, i);
+			m_moveBack(buf, i);
+			m_moveBack(sound, i);
+			m_moveBack(flags, i);
+			m_moveBack(src, i);
+		}
+		//Returns the current index of the voice the handle refers to, or INVALID if the voice is gone.
+		uint32_t find(VoiceHandle handle) const
+		{
+			if (handle.index >= m_slotToDense.size() || m_generation[handle.index] != handle.generation) return INVALID;
+			return m_slotToDense[handle.index];
+		}
+		//Returns the handle for the voice at the given index.
+		VoiceHandle getHandle(uint32_t i) const
+		{
+			VoiceHandle handle;
+			handle.index = m_denseToSlot[i];
+			handle.generation = m_generation[handle.index];
+			return handle;
+		}
+		//Removes every voice. Every outstanding handle goes stale.
+		void clear()
+		{
+			while (!entity.empty()) erase((uint32_t)entity.size() - 1);
+		}
+		//Reserves room for the given number of voices so that playing sounds doesn't reallocate.
+		void reserve(size_t count)
+		{
+			m_denseToSlot.reserve(count);
+			entity.reserve(count);
+			posX.reserve(count); posY.reserve(count); posZ.reserve(count);
+			velX.reserve(count); velY.reserve(count); velZ.reserve(count);
+			gain.reserve(count);
+			pitch.reserve(count);
+			refDist.reserve(count);
+			maxDist.reserve(count);
+			length.reserve(count);
+			playTime.reserve(count);
+			realTime.reserve(count);
+			audibility.reserve(count);
+			buf.reserve(count);
+			sound.reserve(count);
+			flags.reserve(count);
+			src.reserve(count);
+		}
+		//Takes the next slot that's been freed up, with the generation it moved on to, for handing back to the allocator.
+		bool popReleased(VoiceHandle& next)
+		{
+			if (m_released.empty()) return false;
+			next = m_released.back();
+			m_released.pop_back();
+			return true;
+		}
+		size_t size() const { return entity.size(); }
+		bool empty() const { return entity.empty(); }
+
+		AlVec3f getPos(uint32_t i) const { return AlVec3f(posX[i], posY[i], posZ[i]); }
+		void setPos(uint32_t i, const AlVec3f& pos) { posX[i] = pos.x; posY[i] = pos.y; posZ[i] = pos.z; }
+		AlVec3f getVel(uint32_t i) const { return AlVec3f(velX[i], velY[i], velZ[i]); }
+		void setVel(uint32_t i, const AlVec3f& vel) { velX[i] = vel.x; velY[i] = vel.y; velZ[i] = vel.z; }
+
+		std::vector<T> entity;
+		std::vector<float> posX, posY, posZ;
+		std::vector<float> velX, velY, velZ;
+		std::vector<float> gain;
+		std::vector<float> pitch;
+		std::vector<float> refDist;
+		std::vector<float> maxDist;
+		std::vector<float> length; //length of the buffer in seconds
+		std::vector<float> playTime; //how far into the buffer the voice is, in seconds
+		std::vector<float> realTime; //how long the voice has held onto its current source, in seconds
+		std::vector<float> audibility;
+		std::vector<ALuint> buf;
+		std::vector<uint32_t> sound; //index into the driver's sound table
+		std::vector<uint8_t> flags;
+		std::vector<AudioSource*> src; //checked out of the source pool while the voice is real, null while it's virtual
+	private:
+		void m_growSlots(uint32_t slot)
+		{
+			if (slot < m_slotToDense.size()) return;
+			m_slotToDense.resize(slot + 1, INVALID);
+			m_generation.resize(slot + 1, 0);
+		}
+		void m_release(uint32_t slot)
+		{
+			VoiceHandle next;
+			next.index = slot;
+			next.generation = m_generation[slot];
+			m_released.push_back(next);
+		}
+		template<class V>
+		static void m_moveBack(std::vector<V>& vec, uint32_t i)
+		{
+			if (i + 1 != vec.size()) vec[i] = std::move(vec.back());
+			vec.pop_back();
+		}
+
+		std::vector<uint32_t> m_slotToDense;
+		std::vector<uint32_t> m_denseToSlot;
+		std::vector<uint32_t> m_generation;
+		std::vector<VoiceHandle> m_released;
+};
+
+#endif
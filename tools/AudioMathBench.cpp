@@ -0,0 +1,174 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/*
+* Command line tool that checks the vectorized kernels in AudioMath against their scalar versions and measures how fast they are. Any
+* difference from the scalar results fails the run, so this doubles as a test of whichever path the machine picks. The 16-bit conversion is
+* checked against the loop ov_read runs, since the decoder used to go through ov_read and its output shouldn't have changed.
+*
+* Build it alongside AudioMath.cpp with optimizations on, e.g.
+*	cl /std:c++17 /O2 /EHsc /I include /I openal\include tools\AudioMathBench.cpp AudioMath.cpp
+*
+* Usage: AudioMathBench [repetitions]
+*/
+#include "AudioMath.h"
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+namespace {
+	//Random emitters around the listener, with some where the reference and maximum distance are the same to hit that edge case.
+	struct Emitters {
+		std::vector<float> posX, posY, posZ, gain, refDist, maxDist;
+
+		explicit Emitters(size_t count)
+			: posX(count), posY(count), posZ(count), gain(count), refDist(count), maxDist(count)
+		{
+			std::mt19937 gen(1);
+			std::uniform_real_distribution<float> pos(-2000.f, 2000.f), level(0.f, 1.f), ref(1.f, 50.f), max(50.f, 1500.f);
+			for (size_t i = 0; i < count; ++i) {
+				posX[i] = pos(gen); posY[i] = pos(gen); posZ[i] = pos(gen);
+				gain[i] = level(gen);
+				refDist[i] = ref(gen);
+				maxDist[i] = i % 7 == 0 ? refDist[i] : max(gen);
+			}
+		}
+		EmitterArrays arrays() const
+		{
+			EmitterArrays e;
+			e.posX = posX.data(); e.posY = posY.data(); e.posZ = posZ.data();
+			e.gain = gain.data(); e.refDist = refDist.data(); e.maxDist = maxDist.data();
+			e.count = posX.size();
+			return e;
+		}
+	};
+
+	//Checks computeAudibility against computeAudibilityScalar, then times both. Returns false if they disagree.
+	bool benchAudibility(int reps)
+	{
+		const size_t COUNT = 10003; //not a multiple of any vector width, so the tails get checked too
+		Emitters emitters(COUNT);
+		EmitterArrays e = emitters.arrays();
+		AlVec3f listener(10.f, 20.f, 30.f);
+		const float cullDistSq = 1500.f * 1500.f;
+
+		std::vector<float> audibility(COUNT), expected(COUNT), distance(COUNT), expectedDistance(COUNT);
+		std::vector<uint8_t> cull(COUNT), expectedCull(COUNT);
+		computeAudibility(e, listener, .8f, cullDistSq, audibility.data(), cull.data(), distance.data());
+		computeAudibilityScalar(e, listener, .8f, cullDistSq, expected.data(), expectedCull.data(), expectedDistance.data());
+		float maxError = 0.f, maxDistError = 0.f;
+		size_t cullMismatches = 0;
+		for (size_t i = 0; i < COUNT; ++i) {
+			maxError = std::max(maxError, std::fabs(audibility[i] - expected[i]));
+			maxDistError = std::max(maxDistError, std::fabs(distance[i] - expectedDistance[i]) / std::max(expectedDistance[i], 1.f));
+			if (cull[i] != expectedCull[i]) ++cullMismatches;
+		}
+		printf("audibility: max error %g, max relative distance error %g, %zu culling mismatches\n", maxError, maxDistError, cullMismatches);
+
+		double simdNs = 0.0, scalarNs = 0.0;
+		for (int pass = 0; pass < 2; ++pass) {
+			auto kernel = pass == 0 ? computeAudibility : computeAudibilityScalar;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; ++r) kernel(e, listener, .8f + r * 1e-6f, cullDistSq, audibility.data(), cull.data(), nullptr);
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ((double)reps * COUNT);
+			(pass == 0 ? simdNs : scalarNs) = ns;
+		}
+		printf("audibility: %s %.3f ns per emitter, scalar %.3f ns per emitter (%.1fx)\n", audioMathPath(), simdNs, scalarNs, scalarNs / simdNs);
+		return maxError <= 1e-5f && maxDistError <= 1e-5f && cullMismatches == 0;
+	}
+
+	//The conversion vorbisfile's ov_read does for 16-bit signed little-endian output, which is what the decoder used before
+	//interleaveInt16.
+	void ovReadConvert(const float* const* planes, int channels, size_t frames, int16_t* out)
+	{
+		for (size_t j = 0; j < frames; ++j) {
+			for (int c = 0; c < channels; ++c) {
+				int value = (int)lrintf(planes[c][j] * 32768.f);
+				if (value > 32767) value = 32767;
+				if (value < -32768) value = -32768;
+				out[j * channels + c] = (int16_t)value;
+			}
+		}
+	}
+
+	template<class F>
+	double timeMs(int reps, F&& run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; ++r) run();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Checks the planar to interleaved conversions against ov_read's loop and a plain copy, then times them. Returns false if they disagree.
+	bool benchConversion(int reps)
+	{
+		const size_t FRAMES = (1 << 18) + 3;
+		reps = std::max(1, reps / 100);
+		std::mt19937 gen(3);
+		std::uniform_real_distribution<float> sample(-1.2f, 1.2f); //past full scale, so clipping gets checked too
+		bool ok = true;
+		for (int channels = 1; channels <= 2; ++channels) {
+			std::vector<std::vector<float>> planes(channels, std::vector<float>(FRAMES));
+			std::vector<const float*> planePtrs;
+			for (auto& plane : planes) {
+				for (float& x : plane) x = sample(gen);
+				planePtrs.push_back(plane.data());
+			}
+			std::vector<int16_t> pcm16(FRAMES * channels), expected16(FRAMES * channels);
+			std::vector<float> pcm32(FRAMES * channels);
+			interleaveInt16(planePtrs.data(), channels, FRAMES, pcm16.data());
+			ovReadConvert(planePtrs.data(), channels, FRAMES, expected16.data());
+			interleaveFloat(planePtrs.data(), channels, FRAMES, pcm32.data());
+			size_t mismatches16 = 0, mismatches32 = 0;
+			for (size_t i = 0; i < FRAMES * channels; ++i) {
+				if (pcm16[i] != expected16[i]) ++mismatches16;
+				if (pcm32[i] != planes[i % channels][i / channels]) ++mismatches32;
+			}
+
+			double ms16 = timeMs(reps, [&]() { interleaveInt16(planePtrs.data(), channels, FRAMES, pcm16.data()); });
+			double msLoop = timeMs(reps, [&]() { ovReadConvert(planePtrs.data(), channels, FRAMES, expected16.data()); });
+			double ms32 = timeMs(reps, [&]() { interleaveFloat(planePtrs.data(), channels, FRAMES, pcm32.data()); });
+			double mb16 = (double)FRAMES * channels * 2 * reps / 1e6, mb32 = (double)FRAMES * channels * 4 * reps / 1e6;
+			printf("%d channel conversion: int16 %.0f MB/s (ov_read loop %.0f MB/s), float32 %.0f MB/s, %zu int16 and %zu float32 mismatches\n",
+				channels, mb16 / (ms16 / 1000.0), mb16 / (msLoop / 1000.0), mb32 / (ms32 / 1000.0), mismatches16, mismatches32);
+			ok = ok && mismatches16 == 0 && mismatches32 == 0;
+		}
+		return ok;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int reps = argc > 1 ? std::atoi(argv[1]) : 2000;
+	if (reps <= 0) {
+		std::cerr << "Usage: " << argv[0] << " [repetitions]\n";
+		return 1;
+	}
+	std::cout << "Audio math path: " << audioMathPath() << std::endl;
+	bool ok = benchAudibility(reps);
+	ok = benchConversion(reps) && ok;
+	if (!ok) std::cerr << "The " << audioMathPath() << " kernels don't match the scalar ones.\n";
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/*
+* Command line tool that measures load-time decode throughput on real .ogg files, in MB of PCM per second. Each file gets decoded three
+* ways: the old loop (ov_read in 4096 byte chunks into a malloc'd 16-bit buffer), and the current one (ov_read_float converted straight
+* into the final buffer by AudioMath) for both 16-bit and float32 output. The 16-bit output of the two has to come out identical. Files are
+* read into memory first so the disk isn't part of the timing.
+*
+* Build it alongside AudioMath.cpp with optimizations on, e.g.
+*	cl /std:c++17 /O2 /EHsc /I include /I openal\include /I vorbis\include tools\DecodeBench.cpp AudioMath.cpp
+*		/link /LIBPATH:vorbis\lib libogg.lib libvorbis_static.lib libvorbisfile_static.lib
+*
+* Usage: DecodeBench <file.ogg> [more files...]
+*/
+#include "AudioMath.h"
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <ogg.h>
+#include <vorbisfile.h>
+
+namespace {
+	//An .ogg file sitting in memory, read through the vorbisfile callbacks.
+	struct MemoryReader {
+		const char* data;
+		size_t size;
+		size_t pos;
+	};
+
+	size_t memoryRead(void* ptr, size_t size, size_t count, void* source)
+	{
+		MemoryReader* reader = (MemoryReader*)source;
+		size_t bytes = std::min(size * count, reader->size - reader->pos);
+		memcpy(ptr, reader->data + reader->pos, bytes);
+		reader->pos += bytes;
+		return size ? bytes / size : 0;
+	}
+
+	int memorySeek(void* source, ogg_int64_t offset, int whence)
+	{
+		MemoryReader* reader = (MemoryReader*)source;
+		ogg_int64_t pos = 0;
+		switch (whence) {
+			case SEEK_SET: pos = offset; break;
+			case SEEK_CUR: pos = (ogg_int64_t)reader->pos + offset; break;
+			case SEEK_END: pos = (ogg_int64_t)reader->size + offset; break;
+			default: return -1;
+		}
+		if (pos < 0 || pos > (ogg_int64_t)reader->size) return -1;
+		reader->pos = (size_t)pos;
+		return 0;
+	}
+
+	long memoryTell(void* source)
+	{
+		return (long)((MemoryReader*)source)->pos;
+	}
+
+	bool openMemory(const std::vector<char>& file, MemoryReader& reader, OggVorbis_File& vf)
+	{
+		reader = { file.data(), file.size(), 0 };
+		ov_callbacks callbacks = { memoryRead, memorySeek, NULL, memoryTell };
+		return ov_open_callbacks(&reader, &vf, NULL, 0, callbacks) >= 0;
+	}
+
+	//The old loader's decode loop.
+	size_t decodeOvRead(const std::vector<char>& file, std::vector<char>& out)
+	{
+		MemoryReader reader;
+		OggVorbis_File vf;
+		if (!openMemory(file, reader, vf)) return 0;
+		vorbis_info* vi = ov_info(&vf, -1);
+		size_t dataLength = (size_t)ov_pcm_total(&vf, -1) * vi->channels * 2;
+		char* pcm = (char*)malloc(dataLength);
+		size_t offset = 0;
+		int sel = 0;
+		long size = 0;
+		while (pcm && (size = ov_read(&vf, pcm + offset, (int)std::min<size_t>(4096, dataLength - offset), 0, 2, 1, &sel)) != 0) {
+			if (size < 0) {
+				if (size == OV_HOLE) continue;
+				break;
+			}
+			offset += (size_t)size;
+		}
+		if (pcm) out.assign(pcm, pcm + offset);
+		free(pcm);
+		ov_clear(&vf);
+		return offset;
+	}
+
+	//The current decode loop, minus the downmixing and resampling.
+	size_t decodeFloat(const std::vector<char>& file, bool float32, std::vector<char>& out)
+	{
+		MemoryReader reader;
+		OggVorbis_File vf;
+		if (!openMemory(file, reader, vf)) return 0;
+		vorbis_info* vi = ov_info(&vf, -1);
+		size_t totalFrames = (size_t)ov_pcm_total(&vf, -1);
+		size_t frameBytes = (size_t)vi->channels * (float32 ? 4 : 2);
+		out.resize(totalFrames * frameBytes);
+		size_t frames = 0;
+		int sel = 0;
+		while (frames < totalFrames) {
+			float** planes = nullptr;
+			long got = ov_read_float(&vf, &planes, (int)std::min<size_t>(4096, totalFrames - frames), &sel);
+			if (got == 0) break;
+			if (got < 0) {
+				if (got == OV_HOLE) continue;
+				break;
+			}
+			if (float32) interleaveFloat(planes, vi->channels, (size_t)got, (float*)out.data() + frames * vi->channels);
+			else interleaveInt16(planes, vi->channels, (size_t)got, (int16_t*)out.data() + frames * vi->channels);
+			frames += (size_t)got;
+		}
+		ov_clear(&vf);
+		out.resize(frames * frameBytes);
+		return out.size();
+	}
+
+	template<class F>
+	double timeMs(F&& run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		run();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <file.ogg> [more files...]\n";
+		return 1;
+	}
+	std::cout << "Audio math path: " << audioMathPath() << std::endl;
+	printf("%-32s %12s %12s %12s %12s\n", "file", "PCM MB", "ov_read MB/s", "int16 MB/s", "float32 MB/s");
+	bool ok = true;
+	double totalMB = 0.0, totalOld = 0.0, totalInt16 = 0.0, totalFloat = 0.0;
+	for (int a = 1; a < argc; ++a) {
+		std::ifstream in(argv[a], std::ios::binary);
+		std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (file.empty()) {
+			std::cerr << "Could not read " << argv[a] << std::endl;
+			ok = false;
+			continue;
+		}
+		std::vector<char> old, pcm16, pcm32;
+		size_t bytes = 0;
+		double oldMs = timeMs([&]() { bytes = decodeOvRead(file, old); });
+		double int16Ms = timeMs([&]() { decodeFloat(file, false, pcm16); });
+		double floatMs = timeMs([&]() { decodeFloat(file, true, pcm32); });
+		if (bytes == 0) {
+			std::cerr << "Not a valid OggVorbis stream: " << argv[a] << std::endl;
+			ok = false;
+			continue;
+		}
+		if (old != pcm16) {
+			std::cerr << "16-bit output doesn't match ov_read for " << argv[a] << std::endl;
+			ok = false;
+		}
+		double mb = bytes / 1e6;
+		printf("%-32s %12.2f %12.0f %12.0f %12.0f\n", argv[a], mb, mb / (oldMs / 1000.0), mb / (int16Ms / 1000.0), 2 * mb / (floatMs / 1000.0));
+		totalMB += mb;
+		totalOld += oldMs;
+		totalInt16 += int16Ms;
+		totalFloat += floatMs;
+	}
+	if (totalMB > 0.0) {
+		printf("%-32s %12.2f %12.0f %12.0f %12.0f\n", "total", totalMB, totalMB / (totalOld / 1000.0), totalMB / (totalInt16 / 1000.0),
+			2 * totalMB / (totalFloat / 1000.0));
+	}
+	return ok ? 0 : 1;
+}
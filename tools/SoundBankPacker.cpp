@@ -0,0 +1,79 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/*
+* Command line tool that packs a directory of .ogg files into a sound bank. Every .ogg under the directory (including subdirectories) goes
+* into the bank under its path relative to the directory, using forward slashes, so "sfx/impact_1.ogg" is looked up as "sfx/impact_1.ogg".
+*
+* Build it alongside SoundBank.cpp and MappedFile.cpp, e.g.
+*	cl /std:c++17 /EHsc /I include tools\SoundBankPacker.cpp SoundBank.cpp MappedFile.cpp
+*
+* Usage: SoundBankPacker <input directory> <output bank>
+*/
+#include "SoundBank.h"
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv)
+{
+	if (argc != 3) {
+		std::cerr << "Usage: " << argv[0] << " <input directory> <output bank>\n";
+		return 1;
+	}
+	fs::path root(argv[1]);
+	std::error_code err;
+	if (!fs::is_directory(root, err)) {
+		std::cerr << "Not a directory: " << root.string() << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> names;
+	std::vector<std::string> paths;
+	for (const auto& entry : fs::recursive_directory_iterator(root, err)) {
+		if (!entry.is_regular_file()) continue;
+		std::string ext = entry.path().extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+		if (ext != ".ogg") continue;
+		names.push_back(fs::relative(entry.path(), root).generic_string());
+		paths.push_back(entry.path().string());
+	}
+	if (err) {
+		std::cerr << "Could not read directory: " << err.message() << std::endl;
+		return 1;
+	}
+	if (names.empty()) {
+		std::cerr << "No .ogg files found in " << root.string() << std::endl;
+		return 1;
+	}
+
+	if (!SoundBank::pack(argv[2], names, paths)) return 1;
+
+	SoundBank check; //make sure what we wrote actually reads back
+	if (!check.open(argv[2]) || check.getCount() != names.size()) {
+		std::cerr << "Sound bank failed to read back: " << argv[2] << std::endl;
+		return 1;
+	}
+	std::cout << "Packed " << names.size() << " sounds into " << argv[2] << std::endl;
+	return 0;
+}
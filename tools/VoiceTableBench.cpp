@@ -0,0 +1,174 @@
+/*
+*
+	An OpenAL wrapper in C++ meant for use with game environments.
+	Copyright (C) 2023 Alexander Wiecking
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/*
+* Command line tool that measures what a game sound update costs at 100, 1,000 and 10,000 active voices. It runs the same passes over a
+* VoiceTable that gameSoundUpdate does for virtual voices - advancing playback, working out audibility and picking the top voices - and the
+* same bookkeeping over a std::list of heap-allocated sounds, which is how active sounds used to be stored, for comparison. Nothing here
+* talks to OpenAL, so it runs without a device.
+*
+* Build it alongside AudioMath.cpp with optimizations on, e.g.
+*	cl /std:c++17 /O2 /EHsc /I include /I openal\include tools\VoiceTableBench.cpp AudioMath.cpp
+*
+* Usage: VoiceTableBench [updates per size]
+*/
+#include "VoiceTable.h"
+#include "AudioMath.h"
+#include <list>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+namespace {
+	//One sound the way the old list stored it.
+	struct ListSound {
+		int entity = 0;
+		AlVec3f pos;
+		AlVec3f vel;
+		float gain = 1.f;
+		float pitch = 1.f;
+		float refDist = 20.f;
+		float maxDist = 1200.f;
+		float length = 0.f;
+		float playTime = 0.f;
+		float audibility = 0.f;
+		ALuint buf = 0;
+		uint8_t flags = 0;
+	};
+
+	const float DT = 1.f / 100.f;
+	const size_t MAX_REAL = 64;
+
+	//Fills both containers with the same sounds scattered around the listener.
+	void fill(size_t count, VoiceTable<int>& table, std::list<std::unique_ptr<ListSound>>& list)
+	{
+		std::mt19937 gen(7);
+		std::uniform_real_distribution<float> pos(-2000.f, 2000.f), len(.5f, 8.f), gain(.2f, 1.f);
+		for (size_t n = 0; n < count; ++n) {
+			VoiceHandle handle;
+			handle.index = (uint32_t)n;
+			handle.generation = 1;
+			table.insert(handle);
+			uint32_t i = (uint32_t)table.size() - 1;
+			table.setPos(i, AlVec3f(pos(gen), pos(gen), pos(gen)));
+			table.gain[i] = gain(gen);
+			table.length[i] = len(gen);
+			table.flags[i] = VoiceTable<int>::LOOP;
+
+			auto sound = std::make_unique<ListSound>();
+			sound->pos = table.getPos(i);
+			sound->gain = table.gain[i];
+			sound->length = table.length[i];
+			sound->flags = table.flags[i];
+			list.push_back(std::move(sound));
+		}
+	}
+
+	//One update over the voice table: the playback sweep, the vectorized audibility pass, and the top voices.
+	void updateTable(VoiceTable<int>& v, const AlVec3f& listener, std::vector<uint8_t>& cull, std::vector<uint32_t>& ranked)
+	{
+		for (uint32_t i = 0; i < v.size(); ++i) {
+			v.playTime[i] += DT * v.pitch[i];
+			if (v.playTime[i] >= v.length[i]) v.playTime[i] = std::fmod(v.playTime[i], v.length[i]);
+		}
+		EmitterArrays e;
+		e.posX = v.posX.data(); e.posY = v.posY.data(); e.posZ = v.posZ.data();
+		e.gain = v.gain.data(); e.refDist = v.refDist.data(); e.maxDist = v.maxDist.data();
+		e.count = v.size();
+		cull.resize(v.size());
+		computeAudibility(e, listener, 1.f, 1500.f * 1500.f, v.audibility.data(), cull.data());
+		ranked.clear();
+		for (uint32_t i = 0; i < v.size(); ++i) ranked.push_back(i);
+		size_t cutoff = std::min(MAX_REAL, ranked.size());
+		std::nth_element(ranked.begin(), ranked.begin() + cutoff, ranked.end(),
+			[&v](uint32_t a, uint32_t b) { return v.audibility[a] > v.audibility[b]; });
+	}
+
+	//The same update over the list, one sound at a time.
+	void updateList(std::list<std::unique_ptr<ListSound>>& list, const AlVec3f& listener, std::vector<ListSound*>& ranked)
+	{
+		ranked.clear();
+		for (auto& sound : list) {
+			sound->playTime += DT * sound->pitch;
+			if (sound->playTime >= sound->length) sound->playTime = std::fmod(sound->playTime, sound->length);
+			float dist = (sound->pos - listener).length();
+			float clamped = std::min(std::max(dist, sound->refDist), sound->maxDist);
+			float range = sound->maxDist - sound->refDist;
+			float atten = range > 0.f ? 1.f - (clamped - sound->refDist) / range : (dist <= sound->refDist ? 1.f : 0.f);
+			sound->audibility = dist > 1500.f ? 0.f : sound->gain * atten;
+			ranked.push_back(sound.get());
+		}
+		size_t cutoff = std::min(MAX_REAL, ranked.size());
+		std::nth_element(ranked.begin(), ranked.begin() + cutoff, ranked.end(),
+			[](const ListSound* a, const ListSound* b) { return a->audibility > b->audibility; });
+	}
+
+	template<class F>
+	double timeUpdates(int updates, F&& update)
+	{
+		update(); //warm up
+		auto start = std::chrono::steady_clock::now();
+		for (int n = 0; n < updates; ++n) update();
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / updates;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int updates = argc > 1 ? std::atoi(argv[1]) : 2000;
+	if (updates <= 0) {
+		std::cerr << "Usage: " << argv[0] << " [updates per size]\n";
+		return 1;
+	}
+	std::cout << "Audio math path: " << audioMathPath() << std::endl;
+	printf("%8s %14s %14s %8s\n", "voices", "table us/upd", "list us/upd", "speedup");
+	const size_t sizes[] = { 100, 1000, 10000 };
+	for (size_t count : sizes) {
+		VoiceTable<int> table;
+		std::list<std::unique_ptr<ListSound>> list;
+		table.reserve(count);
+		fill(count, table, list);
+
+		AlVec3f listener(10.f, 20.f, 30.f);
+		std::vector<uint8_t> cull;
+		std::vector<uint32_t> rankedTable;
+		std::vector<ListSound*> rankedList;
+		double tableUs = timeUpdates(updates, [&]() { updateTable(table, listener, cull, rankedTable); });
+		double listUs = timeUpdates(updates, [&]() { updateList(list, listener, rankedList); });
+
+		//both sides have to agree on how loud everything is, or the comparison means nothing
+		size_t mismatches = 0;
+		uint32_t i = 0;
+		for (auto& sound : list) {
+			if (std::fabs(sound->audibility - table.audibility[i++]) > 1e-4f) ++mismatches;
+		}
+		printf("%8zu %14.2f %14.2f %7.1fx\n", count, tableUs, listUs, listUs / tableUs);
+		if (mismatches > 0) {
+			std::cerr << mismatches << " voices came out with different audibility between the table and the list.\n";
+			return 1;
+		}
+	}
+	return 0;
+}